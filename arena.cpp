@@ -0,0 +1,57 @@
+#include <cstdint>
+
+#include "arena.hpp"
+
+namespace ast {
+
+    Arena::Arena() : cursor(nullptr), end(nullptr), used_bytes(0), block_bytes(0) {}
+
+    Arena::~Arena() {
+        reset();
+    }
+
+    void Arena::reset() {
+        // Destroy in reverse allocation order, parents before their children
+        for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+            (*it)->~Node();
+        }
+        nodes.clear();
+
+        if (!blocks.empty()) {
+            blocks.resize(1);
+            cursor = blocks.front().get();
+            end = cursor + BLOCK_SIZE;
+            block_bytes = BLOCK_SIZE;
+        }
+        used_bytes = 0;
+    }
+
+    const std::vector<Node *> &Arena::allocatedNodes() const {
+        return nodes;
+    }
+
+    MemoryUsage Arena::memoryUsage() const {
+        MemoryUsage usage;
+        usage.objects = blocks.size();
+        usage.live_bytes = used_bytes + nodes.size() * sizeof(Node *);
+        usage.peak_bytes = block_bytes + nodes.capacity() * sizeof(Node *);
+        return usage;
+    }
+
+    void *Arena::allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        if (!cursor || cursor + padding + size > end) {
+            size_t block_size = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+            blocks.emplace_back(new char[block_size]);
+            block_bytes += block_size;
+            cursor = blocks.back().get();
+            end = cursor + block_size;
+            padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        }
+
+        void *memory = cursor + padding;
+        cursor += padding + size;
+        used_bytes += padding + size;
+        return memory;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "nodes.hpp"
+#include "mem_report.hpp"
+
+namespace ast {
+
+    /* Arena class
+     * Owns every node of an AST. Nodes are bump-allocated from large blocks and are all destroyed together with the
+     * arena, so there is no per-node reference counting and no per-node free.
+     */
+    class Arena {
+    public:
+        Arena();
+
+        ~Arena();
+
+        Arena(const Arena &) = delete;
+
+        Arena &operator=(const Arena &) = delete;
+
+        // Allocates a node in the arena and constructs it with the given arguments
+        template <typename T, typename... Args>
+        T *make(Args &&... args) {
+            static_assert(std::is_base_of<Node, T>::value, "the arena only holds AST nodes");
+            T *node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            nodes.push_back(node);
+            return node;
+        }
+
+        // Destroys every node, keeping the first block for reuse
+        void reset();
+
+        // Every node allocated since the last reset
+        const std::vector<Node *> &allocatedNodes() const;
+
+        // Blocks, with the bytes handed out to nodes and the bytes of the blocks and of the node list
+        MemoryUsage memoryUsage() const;
+
+    private:
+        static const size_t BLOCK_SIZE = 64 * 1024;
+
+        void *allocate(size_t size, size_t alignment);
+
+        std::vector<std::unique_ptr<char[]>> blocks;
+        // Free space of the last block
+        char *cursor;
+        char *end;
+        // Bytes handed out since the last reset, alignment included, and bytes of the blocks
+        size_t used_bytes;
+        size_t block_bytes;
+        // Every node allocated so far, in allocation order
+        std::vector<Node *> nodes;
+    };
+}
+
+#endif //ARENA_HPP
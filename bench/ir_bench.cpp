@@ -0,0 +1,152 @@
+/* Benchmark of the lowering to IR and of the SSA construction, on a single function that grows from 1k to 128k
+ * statements: assignments, ifs with short-circuit conditions and whiles with breaks, over a few variables.
+ *
+ * The construction is near-linear when ns_per_statement stays about the same as the function doubles. It rises at
+ * first, while the function outgrows the caches, and levels off once it no longer fits any of them. Every size
+ * is measured ROUNDS times and the best run is kept. The results are printed as tab-separated values, one line per
+ * size:
+ *   statements  blocks  phis  lower_ns  ssa_ns  ns_per_statement  valid
+ * lower_ns is the IrBuilder, ssa_ns ir::buildSsa, and ns_per_statement the sum of both by statement. valid is the
+ * result of ir::verify on the SSA form.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../arena.hpp"
+#include "../diagnostics.hpp"
+#include "../ir_builder.hpp"
+#include "../parse_context.hpp"
+#include "../semantic_analayzer_visitor.hpp"
+#include "../source_buffer.hpp"
+#include "../ssa_builder.hpp"
+
+namespace {
+
+    int ROUNDS = 5;
+    const int VARIABLES = 8;
+
+    /* Corpus */
+
+    // A function of `statements` statements, each of them one of a few shapes
+    std::string program(int statements) {
+        std::ostringstream text;
+        text << "int big(int p) {\n";
+        for (int i = 0; i < VARIABLES; ++i) {
+            text << "    int v" << i << " = p + " << i << ";\n";
+        }
+        for (int i = 0; i < statements; ++i) {
+            int a = i % VARIABLES;
+            int b = (i * 3 + 1) % VARIABLES;
+            int c = (i * 5 + 2) % VARIABLES;
+            switch (i % 4) {
+                case 0:
+                    text << "    v" << a << " = v" << b << " + v" << c << " * 3;\n";
+                    break;
+                case 1:
+                    text << "    if (v" << a << " > v" << b << " and v" << c << " < 100) {\n"
+                         << "        v" << a << " = v" << a << " - 1;\n"
+                         << "    } else {\n"
+                         << "        v" << b << " = v" << b << " + 2;\n"
+                         << "    }\n";
+                    break;
+                case 2:
+                    text << "    while (v" << a << " < v" << b << " or v" << c << " == 0) {\n"
+                         << "        v" << a << " = v" << a << " + 1;\n"
+                         << "        if (v" << a << " == 7) break;\n"
+                         << "    }\n";
+                    break;
+                default:
+                    text << "    if (v" << c << " != v" << a << ") v" << c << " = v" << a << " / 2;\n";
+            }
+        }
+        text << "    return v0;\n"
+             << "}\n"
+             << "void main() {\n"
+             << "    printi(big(1));\n"
+             << "}\n";
+        return text.str();
+    }
+
+    /* Timing */
+
+    double elapsed(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Parses and analyzes the program, and fails if it has an error. The identifiers are bound to the symbols of
+    // `visitor`, which must outlive the AST
+    ast::Node *analyze(SourceBuffer &source, ast::Arena &arena, SemanticAnalayzerVisitor &visitor) {
+        output::Diagnostics diagnostics;
+        output::Diagnostics *previous = output::setDiagnostics(&diagnostics);
+        ast::Node *program = nullptr;
+        try {
+            program = ast::parse(source, arena);
+            program->accept(visitor);
+        } catch (const output::CompilationError &) {
+            std::fprintf(stderr, "ir_bench: the corpus has an error:\n");
+            std::cerr << diagnostics;
+            std::exit(1);
+        }
+        output::setDiagnostics(previous);
+        return program;
+    }
+}
+
+// Usage: ir_bench [rounds]
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        ROUNDS = std::max(1, std::atoi(argv[1]));
+    }
+
+    std::printf("# hw3 IR lowering and SSA construction of a single function, best of %d rounds\n", ROUNDS);
+    std::printf("statements\tblocks\tphis\tlower_ns\tssa_ns\tns_per_statement\tvalid\n");
+    for (int statements = 1000; statements <= 128000; statements *= 2) {
+        std::string text = program(statements);
+        SourceBuffer source;
+        std::copy(text.begin(), text.end(), source.allocate(text.size()));
+        ast::Arena arena;
+        SemanticAnalayzerVisitor visitor(false);
+        ast::Node *root = analyze(source, arena, visitor);
+
+        double lower_ns = 0;
+        double ssa_ns = 0;
+        size_t blocks = 0;
+        size_t phis = 0;
+        bool valid = true;
+        for (int round = 0; round < ROUNDS; ++round) {
+            IrBuilder builder;
+            auto start = std::chrono::steady_clock::now();
+            root->accept(builder);
+            double lower = elapsed(start);
+            ir::Function &function = *builder.functions[0];
+            start = std::chrono::steady_clock::now();
+            ir::buildSsa(function);
+            double ssa = elapsed(start);
+            if (round == 0 || lower + ssa < lower_ns + ssa_ns) {
+                lower_ns = lower;
+                ssa_ns = ssa;
+            }
+
+            blocks = function.blocks.size();
+            phis = 0;
+            for (const ir::Block *block : function.blocks) {
+                for (const ir::Instruction *instruction : block->instructions) {
+                    phis += instruction->opcode == ir::Opcode::PHI;
+                }
+            }
+            valid = valid && ir::verify(function, std::cerr);
+        }
+
+        std::printf("%d\t%zu\t%zu\t%.0f\t%.0f\t%.1f\t%s\n", statements, blocks, phis, lower_ns, ssa_ns,
+                    (lower_ns + ssa_ns) / statements, valid ? "yes" : "NO");
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+/* Microbenchmark of the node type checks: RTTI (typeid / dynamic_cast) against the NodeKind tags
+ * (isa / cast / switch on kind). Every check is run over the same mixed set of nodes and reported in ns per check.
+ */
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../nodes.hpp"
+#include "../arena.hpp"
+
+namespace {
+
+    const int ROUNDS = 200;
+
+    std::vector<ast::Exp *> makeExpressions(ast::Arena &arena) {
+        std::vector<ast::Exp *> exps;
+        Symbol x = StringInterner::global().intern("x");
+        for (int i = 0; i < 10000; ++i) {
+            auto num = arena.make<ast::Num>("1");
+            switch (i % 8) {
+                case 0: exps.push_back(num); break;
+                case 1: exps.push_back(arena.make<ast::NumB>("2")); break;
+                case 2: exps.push_back(arena.make<ast::Bool>(true)); break;
+                case 3: exps.push_back(arena.make<ast::ID>(x)); break;
+                case 4: exps.push_back(arena.make<ast::BinOp>(num, num, ast::ADD)); break;
+                case 5: exps.push_back(arena.make<ast::Call>(arena.make<ast::ID>(x), arena.make<ast::ExpList>())); break;
+                case 6: exps.push_back(arena.make<ast::Cast>(num, arena.make<ast::Type>(ast::INT))); break;
+                default: exps.push_back(arena.make<ast::Or>(num, num)); break;
+            }
+        }
+        return exps;
+    }
+
+    // The classification chain getExpressionType used before the kind tags
+    int classifyRtti(ast::Exp *exp) {
+        if (dynamic_cast<ast::Num *>(exp)) return 0;
+        if (dynamic_cast<ast::NumB *>(exp)) return 1;
+        if (dynamic_cast<ast::String *>(exp)) return 2;
+        if (dynamic_cast<ast::Bool *>(exp)) return 3;
+        if (dynamic_cast<ast::Not *>(exp)) return 3;
+        if (dynamic_cast<ast::RelOp *>(exp)) return 3;
+        if (dynamic_cast<ast::And *>(exp)) return 3;
+        if (dynamic_cast<ast::Or *>(exp)) return 3;
+        if (auto binOp = dynamic_cast<ast::BinOp *>(exp)) return binOp->op;
+        if (auto id = dynamic_cast<ast::ID *>(exp)) return static_cast<int>(id->name);
+        if (auto call = dynamic_cast<ast::Call *>(exp)) return static_cast<int>(call->func_id->name);
+        if (auto cast_node = dynamic_cast<ast::Cast *>(exp)) return cast_node->target_type->type;
+        return -1;
+    }
+
+    int classifyKind(ast::Exp *exp) {
+        switch (exp->kind) {
+            case ast::NodeKind::Num: return 0;
+            case ast::NodeKind::NumB: return 1;
+            case ast::NodeKind::String: return 2;
+            case ast::NodeKind::Bool:
+            case ast::NodeKind::Not:
+            case ast::NodeKind::RelOp:
+            case ast::NodeKind::And:
+            case ast::NodeKind::Or: return 3;
+            case ast::NodeKind::BinOp: return ast::cast<ast::BinOp>(exp)->op;
+            case ast::NodeKind::ID: return static_cast<int>(ast::cast<ast::ID>(exp)->name);
+            case ast::NodeKind::Call: return static_cast<int>(ast::cast<ast::Call>(exp)->func_id->name);
+            case ast::NodeKind::Cast: return ast::cast<ast::Cast>(exp)->target_type->type;
+            default: return -1;
+        }
+    }
+
+    template <typename Check, typename Item>
+    void run(const char *name, const std::vector<Item> &items, Check check) {
+        long sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (const auto &item : items) {
+                sink += check(item);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        std::printf("%-36s %8.2f ns/check  (checksum %ld)\n", name, ns / (double(ROUNDS) * items.size()), sink);
+    }
+}
+
+int main() {
+    ast::Arena arena;
+    std::vector<ast::Exp *> exps = makeExpressions(arena);
+
+    // Statements as the analyzer sees them: about one in four opens a nested block
+    std::vector<ast::Statement *> statements;
+    for (size_t i = 0; i < exps.size(); ++i) {
+        if (i % 4 == 0) {
+            statements.push_back(arena.make<ast::Statements>());
+        } else {
+            statements.push_back(arena.make<ast::Return>(exps[i]));
+        }
+    }
+
+    // Semantic values as the parser sees them: everything is a Node
+    std::vector<ast::Node *> values(exps.begin(), exps.end());
+
+    run("expression type: dynamic_cast", exps, classifyRtti);
+    run("expression type: switch on kind", exps, classifyKind);
+
+    run("is block: typeid", statements, [](const ast::Statement *statement) {
+        return typeid(*statement) == typeid(ast::Statements) ? 1 : 0;
+    });
+    run("is block: isa", statements, [](const ast::Statement *statement) {
+        return ast::isa<ast::Statements>(statement) ? 1 : 0;
+    });
+
+    run("Node -> Exp: dynamic_cast", values, [](ast::Node *value) {
+        return dynamic_cast<ast::Exp *>(value)->typed ? 1 : 0;
+    });
+    run("Node -> Exp: cast", values, [](ast::Node *value) {
+        return ast::cast<ast::Exp>(value)->typed ? 1 : 0;
+    });
+    return 0;
+}
@@ -0,0 +1,192 @@
+/* Per-phase benchmark of the compiler: scanning, parsing, semantic analysis and scope printing, timed separately
+ * on a fixed corpus of generated programs of several shapes and sizes.
+ *
+ * Every phase is run ROUNDS times on every program and the best round is kept. The results are printed as
+ * tab-separated values, one line per program and phase, so two revisions can be compared line by line:
+ *   shape  size  bytes  tokens  phase  ns  ns_per_token  mb_per_s
+ * The scanner cannot be taken out of the parser, and printing happens during the analysis, so two of the phases
+ * are differences:
+ *   lex      the scanner alone (ast::scanTokens)
+ *   parse    ast::parse, minus lex
+ *   analyze  the semantic analysis, without scope output
+ *   emit     the analysis with scope output, written to a stream, minus analyze
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../arena.hpp"
+#include "../diagnostics.hpp"
+#include "../parse_context.hpp"
+#include "../semantic_analayzer_visitor.hpp"
+#include "../source_buffer.hpp"
+
+namespace {
+
+    int ROUNDS = 5;
+
+    /* Corpus */
+
+    // Many locals in a single function, each one reading the previous one
+    std::string wide(int n) {
+        std::string text = "void main() {\n    int v0 = 0;\n";
+        for (int i = 1; i < n; ++i) {
+            text += "    int v" + std::to_string(i) + " = v" + std::to_string(i - 1) + " + 1;\n";
+        }
+        return text + "}\n";
+    }
+
+    // Loops nested n levels deep, each declaring a local. The indentation stops growing at 16 levels, so the size
+    // stays linear in n
+    std::string deep(int n) {
+        std::string text = "void main() {\n    int d = 0;\n";
+        for (int i = 1; i <= n; ++i) {
+            std::string indent(4 * std::min(i, 16), ' ');
+            text += indent + "while (d < " + std::to_string(i) + ") {\n";
+            text += indent + "    int v" + std::to_string(i) + " = d;\n";
+        }
+        for (int i = n; i >= 1; --i) {
+            text += std::string(4 * std::min(i, 16), ' ') + "}\n";
+        }
+        return text + "}\n";
+    }
+
+    // n small functions, each calling the previous one
+    std::string manyFunctions(int n) {
+        std::string text = "int f0(int a) {\n    return a;\n}\n";
+        for (int i = 1; i < n; ++i) {
+            text += "int f" + std::to_string(i) + "(int a) {\n"
+                    "    int s = 0;\n"
+                    "    int k = 0;\n"
+                    "    while (k < a) {\n"
+                    "        byte b = 1b;\n"
+                    "        if (k == 3) {\n"
+                    "            s = s + f" + std::to_string(i - 1) + "(k) * b;\n"
+                    "        } else {\n"
+                    "            s = s - k;\n"
+                    "        }\n"
+                    "        k = k + 1;\n"
+                    "    }\n"
+                    "    return s;\n"
+                    "}\n";
+        }
+        return text + "void main() {\n    printi(f" + std::to_string(n - 1) + "(5));\n}\n";
+    }
+
+    // One arithmetic chain of n operands
+    std::string longExpressions(int n) {
+        const char *operators[] = {"+", "*", "-", "+"};
+        std::string text = "void main() {\n    int x = 1;\n    int y = x";
+        for (int i = 1; i < n; ++i) {
+            text += std::string(" ") + operators[i % 4] + " ";
+            text += i % 3 ? "x" : std::to_string(i % 100);
+        }
+        return text + ";\n}\n";
+    }
+
+    struct Program {
+        const char *shape;
+        int size;
+        std::string text;
+    };
+
+    std::vector<Program> corpus() {
+        std::vector<Program> programs;
+        for (int size : {1000, 8000, 32000}) {
+            programs.push_back({"wide", size, wide(size)});
+        }
+        // The parser stack holds a few entries per level, and bison stops at 10000
+        for (int size : {100, 400, 1000}) {
+            programs.push_back({"deep", size, deep(size)});
+        }
+        for (int size : {100, 1000, 5000}) {
+            programs.push_back({"many_functions", size, manyFunctions(size)});
+        }
+        for (int size : {1000, 8000, 32000}) {
+            programs.push_back({"long_expressions", size, longExpressions(size)});
+        }
+        return programs;
+    }
+
+    /* Timing */
+
+    // Best time of ROUNDS runs of `measured`, in ns. `prepare` runs untimed before every round
+    double best(const std::function<void()> &prepare, const std::function<void()> &measured) {
+        double best_ns = 0;
+        for (int round = 0; round < ROUNDS; ++round) {
+            prepare();
+            auto start = std::chrono::steady_clock::now();
+            measured();
+            auto end = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            if (round == 0 || ns < best_ns) {
+                best_ns = ns;
+            }
+        }
+        return best_ns;
+    }
+
+    // A phase too short to tell apart from the noise has 0 ns, and a throughput of 0
+    void report(const Program &program, size_t tokens, const char *phase, double ns) {
+        double mb_per_s = ns > 0 ? program.text.size() / ns * 1e9 / (1 << 20) : 0;
+        std::printf("%s\t%d\t%zu\t%zu\t%s\t%.0f\t%.2f\t%.2f\n", program.shape, program.size, program.text.size(),
+                    tokens, phase, ns, ns / tokens, mb_per_s);
+    }
+
+    // Analyzes the AST, with or without scope output, and fails if the program has an error
+    void analyze(ast::Node *program, bool print_scopes, std::ostream *out) {
+        output::Diagnostics diagnostics;
+        output::Diagnostics *previous = output::setDiagnostics(&diagnostics);
+        SemanticAnalayzerVisitor visitor(print_scopes);
+        try {
+            program->accept(visitor);
+        } catch (const output::CompilationError &) {
+            std::fprintf(stderr, "phase_bench: the corpus has an error:\n");
+            std::cerr << diagnostics;
+            std::exit(1);
+        }
+        output::setDiagnostics(previous);
+        if (out) {
+            *out << visitor.scope_printer;
+        }
+    }
+}
+
+// Usage: phase_bench [rounds]
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        ROUNDS = std::max(1, std::atoi(argv[1]));
+    }
+
+    std::printf("# hw3 phase benchmark, best of %d rounds\n", ROUNDS);
+    std::printf("shape\tsize\tbytes\ttokens\tphase\tns\tns_per_token\tmb_per_s\n");
+    for (const Program &program : corpus()) {
+        SourceBuffer source;
+        std::copy(program.text.begin(), program.text.end(), source.allocate(program.text.size()));
+        ast::Arena arena;
+        ast::Node *root = nullptr;
+        std::ostringstream out;
+        size_t tokens = 0;
+
+        double lex = best([&] { arena.reset(); }, [&] { tokens = ast::scanTokens(source, arena); });
+        double parse = best([&] { arena.reset(); }, [&] { root = ast::parse(source, arena); });
+        // Every analysis runs on a fresh AST, since the analysis caches types and bindings on the nodes
+        double analysis = best([&] { arena.reset(); root = ast::parse(source, arena); },
+                               [&] { analyze(root, false, nullptr); });
+        double emission = best([&] { arena.reset(); root = ast::parse(source, arena); out.str(std::string()); },
+                               [&] { analyze(root, true, &out); });
+
+        report(program, tokens, "lex", lex);
+        report(program, tokens, "parse", std::max(0.0, parse - lex));
+        report(program, tokens, "analyze", analysis);
+        report(program, tokens, "emit", std::max(0.0, emission - analysis));
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+/* Benchmark of the bytecode virtual machine and of the Jit against a naive AST walk, on a few programs that compute something
+ * for a while: recursion, nested loops, byte arithmetic and calls in a loop.
+ *
+ * All of them run the same analyzed AST, and their output must be the same. Every run is repeated ROUNDS times and the
+ * best one is kept. The results are printed as tab-separated values, one line per program:
+ *   program  ast_ns  compile_ns  vm_ns  jit_compile_ns  jit_ns  speedup  jit_speedup  same_output
+ * compile_ns is the lowering to bytecode, which the VM pays once per program, and jit_compile_ns the translation of
+ * the bytecode to native code on top of it. The speedups are ast_ns / vm_ns and ast_ns / jit_ns.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../arena.hpp"
+#include "../bytecode_compiler.hpp"
+#include "../diagnostics.hpp"
+#include "../jit.hpp"
+#include "../parse_context.hpp"
+#include "../semantic_analayzer_visitor.hpp"
+#include "../source_buffer.hpp"
+#include "../virtual_machine.hpp"
+
+namespace {
+
+    int ROUNDS = 5;
+
+    /* Corpus */
+
+    struct Program {
+        const char *name;
+        std::string text;
+    };
+
+    std::vector<Program> corpus() {
+        return {
+                {"fib", "int fib(int n) {\n"
+                        "    if (n < 2) return n;\n"
+                        "    return fib(n - 1) + fib(n - 2);\n"
+                        "}\n"
+                        "void main() {\n"
+                        "    printi(fib(27));\n"
+                        "}\n"},
+                {"primes", "bool prime(int n) {\n"
+                           "    int d = 2;\n"
+                           "    while (d * d <= n) {\n"
+                           "        if (n / d * d == n) return false;\n"
+                           "        d = d + 1;\n"
+                           "    }\n"
+                           "    return true;\n"
+                           "}\n"
+                           "void main() {\n"
+                           "    int count = 0;\n"
+                           "    int n = 2;\n"
+                           "    while (n < 200000) {\n"
+                           "        if (prime(n)) count = count + 1;\n"
+                           "        n = n + 1;\n"
+                           "    }\n"
+                           "    printi(count);\n"
+                           "}\n"},
+                {"nested_loops", "void main() {\n"
+                                 "    int sum = 0;\n"
+                                 "    int i = 0;\n"
+                                 "    while (i < 1000) {\n"
+                                 "        int j = 0;\n"
+                                 "        byte b = 0b;\n"
+                                 "        while (j < 1000) {\n"
+                                 "            b = b * 3b + 7b;\n"
+                                 "            if (b > 128b and j != i) {\n"
+                                 "                sum = sum + b;\n"
+                                 "            } else {\n"
+                                 "                sum = sum - 1;\n"
+                                 "            }\n"
+                                 "            j = j + 1;\n"
+                                 "        }\n"
+                                 "        i = i + 1;\n"
+                                 "    }\n"
+                                 "    printi(sum);\n"
+                                 "}\n"},
+                {"calls", "int add(int a, int b) {\n"
+                          "    return a + b;\n"
+                          "}\n"
+                          "int twice(int a) {\n"
+                          "    return add(a, a);\n"
+                          "}\n"
+                          "void main() {\n"
+                          "    int x = 0;\n"
+                          "    int i = 0;\n"
+                          "    while (i < 1000000) {\n"
+                          "        x = add(x, twice(i)) / 2;\n"
+                          "        i = i + 1;\n"
+                          "    }\n"
+                          "    printi(x);\n"
+                          "}\n"},
+        };
+    }
+
+    /* Naive AST walk */
+
+    // Evaluates the analyzed AST directly: a map of the variables per call, and flags for the control flow
+    class AstInterpreter : public Visitor {
+    public:
+        AstInterpreter(ast::Funcs &program, std::ostream &out) : out(out) {
+            for (ast::FuncDecl *func : program.funcs) {
+                functions[func->id->name] = func;
+            }
+        }
+
+        void run() {
+            try {
+                call(*functions.at(StringInterner::global().intern("main")), {});
+            } catch (const DivisionByZero &) {
+                out << "Error division by zero" << '\n';
+            }
+        }
+
+        void visit(ast::Num &node) override { value = node.value; }
+
+        void visit(ast::NumB &node) override { value = node.value; }
+
+        void visit(ast::String &node) override {}
+
+        void visit(ast::Bool &node) override { value = node.value; }
+
+        void visit(ast::ID &node) override { value = locals.back()[node.variable]; }
+
+        void visit(ast::BinOp &node) override {
+            int32_t left = eval(node.left);
+            int32_t right = eval(node.right);
+            uint32_t result = 0;
+            switch (node.op) {
+                case ast::BinOpType::ADD:
+                    result = uint32_t(left) + uint32_t(right);
+                    break;
+                case ast::BinOpType::SUB:
+                    result = uint32_t(left) - uint32_t(right);
+                    break;
+                case ast::BinOpType::MUL:
+                    result = uint32_t(left) * uint32_t(right);
+                    break;
+                case ast::BinOpType::DIV:
+                    if (right == 0) {
+                        throw DivisionByZero();
+                    }
+                    result = right == -1 ? 0u - uint32_t(left) : uint32_t(left / right);
+                    break;
+            }
+            bool is_byte =
+                    typeOf(node.left) == ast::BuiltInType::BYTE && typeOf(node.right) == ast::BuiltInType::BYTE;
+            value = is_byte ? int32_t(result & 0xFF) : int32_t(result);
+        }
+
+        void visit(ast::RelOp &node) override {
+            int32_t left = eval(node.left);
+            int32_t right = eval(node.right);
+            switch (node.op) {
+                case ast::RelOpType::EQ:
+                    value = left == right;
+                    break;
+                case ast::RelOpType::NE:
+                    value = left != right;
+                    break;
+                case ast::RelOpType::LT:
+                    value = left < right;
+                    break;
+                case ast::RelOpType::GT:
+                    value = left > right;
+                    break;
+                case ast::RelOpType::LE:
+                    value = left <= right;
+                    break;
+                case ast::RelOpType::GE:
+                    value = left >= right;
+                    break;
+            }
+        }
+
+        void visit(ast::Not &node) override { value = !eval(node.exp); }
+
+        void visit(ast::And &node) override { value = eval(node.left) && eval(node.right); }
+
+        void visit(ast::Or &node) override { value = eval(node.left) || eval(node.right); }
+
+        void visit(ast::Type &node) override {}
+
+        void visit(ast::Cast &node) override {
+            value = eval(node.exp);
+            if (node.target_type->type == ast::BuiltInType::BYTE) {
+                value &= 0xFF;
+            }
+        }
+
+        void visit(ast::ExpList &node) override {}
+
+        void visit(ast::Call &node) override {
+            const std::string &name = node.func_id->text();
+            if (name == "print") {
+                out << ast::cast<ast::String>(node.args->exps[0])->value << '\n';
+            } else if (name == "printi") {
+                out << eval(node.args->exps[0]) << '\n';
+            } else {
+                std::vector<int32_t> args;
+                for (ast::Exp *arg : node.args->exps) {
+                    args.push_back(eval(arg));
+                }
+                value = call(*functions.at(node.func_id->name), args);
+            }
+        }
+
+        void visit(ast::Statements &node) override {
+            for (ast::Statement *statement : node.statements) {
+                statement->accept(*this);
+                if (returning || breaking || continuing) {
+                    return;
+                }
+            }
+        }
+
+        void visit(ast::Break &node) override { breaking = true; }
+
+        void visit(ast::Continue &node) override { continuing = true; }
+
+        void visit(ast::Return &node) override {
+            value = node.exp ? eval(node.exp) : 0;
+            returning = true;
+        }
+
+        void visit(ast::If &node) override {
+            if (eval(node.condition)) {
+                node.then->accept(*this);
+            } else if (node.otherwise) {
+                node.otherwise->accept(*this);
+            }
+        }
+
+        void visit(ast::While &node) override {
+            while (eval(node.condition)) {
+                node.body->accept(*this);
+                continuing = false;
+                if (breaking || returning) {
+                    break;
+                }
+            }
+            breaking = false;
+        }
+
+        void visit(ast::VarDecl &node) override {
+            locals.back()[node.id->variable] = node.init_exp ? eval(node.init_exp) : 0;
+        }
+
+        void visit(ast::Assign &node) override {
+            locals.back()[node.id->variable] = eval(node.exp);
+        }
+
+        void visit(ast::Formal &node) override {}
+
+        void visit(ast::Formals &node) override {}
+
+        void visit(ast::FuncDecl &node) override {}
+
+        void visit(ast::Funcs &node) override {}
+
+    private:
+        // Unwinds every call, like the VM stops the program
+        struct DivisionByZero {};
+
+        int32_t eval(ast::Exp *exp) {
+            exp->accept(*this);
+            return value;
+        }
+
+        // Type of the expression, worked out again on every evaluation
+        ast::BuiltInType typeOf(ast::Exp *exp) {
+            switch (exp->kind) {
+                case ast::NodeKind::NumB:
+                    return ast::BuiltInType::BYTE;
+                case ast::NodeKind::ID:
+                    return ast::cast<ast::ID>(exp)->variable->type;
+                case ast::NodeKind::Call:
+                    return ast::cast<ast::Call>(exp)->func_id->function->return_type;
+                case ast::NodeKind::Cast:
+                    return ast::cast<ast::Cast>(exp)->target_type->type;
+                case ast::NodeKind::BinOp: {
+                    auto bin_op = ast::cast<ast::BinOp>(exp);
+                    bool is_byte = typeOf(bin_op->left) == ast::BuiltInType::BYTE &&
+                                   typeOf(bin_op->right) == ast::BuiltInType::BYTE;
+                    return is_byte ? ast::BuiltInType::BYTE : ast::BuiltInType::INT;
+                }
+                default:
+                    return ast::BuiltInType::INT;
+            }
+        }
+
+        int32_t call(ast::FuncDecl &func, const std::vector<int32_t> &args) {
+            locals.emplace_back();
+            for (size_t i = 0; i < args.size(); ++i) {
+                locals.back()[func.formals->formals[i]->id->variable] = args[i];
+            }
+            value = 0;
+            func.body->accept(*this);
+            int32_t result = returning ? value : 0;
+            returning = false;
+            locals.pop_back();
+            return result;
+        }
+
+        std::ostream &out;
+        std::unordered_map<Symbol, ast::FuncDecl *> functions;
+        std::vector<std::unordered_map<const SymbolEntry *, int32_t>> locals;
+        int32_t value = 0;
+        bool returning = false;
+        bool breaking = false;
+        bool continuing = false;
+    };
+
+    /* Timing */
+
+    // Best time of ROUNDS runs of `measured`, in ns. `prepare` runs untimed before every round
+    double best(const std::function<void()> &prepare, const std::function<void()> &measured) {
+        double best_ns = 0;
+        for (int round = 0; round < ROUNDS; ++round) {
+            prepare();
+            auto start = std::chrono::steady_clock::now();
+            measured();
+            auto end = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            if (round == 0 || ns < best_ns) {
+                best_ns = ns;
+            }
+        }
+        return best_ns;
+    }
+
+    // Parses and analyzes the program, and fails if it has an error. The identifiers are bound to the symbols of
+    // `visitor`, which must outlive the AST
+    ast::Funcs *analyze(SourceBuffer &source, ast::Arena &arena, SemanticAnalayzerVisitor &visitor) {
+        output::Diagnostics diagnostics;
+        output::Diagnostics *previous = output::setDiagnostics(&diagnostics);
+        ast::Node *program = nullptr;
+        try {
+            program = ast::parse(source, arena);
+            program->accept(visitor);
+        } catch (const output::CompilationError &) {
+            std::fprintf(stderr, "vm_bench: the corpus has an error:\n");
+            std::cerr << diagnostics;
+            std::exit(1);
+        }
+        output::setDiagnostics(previous);
+        return ast::cast<ast::Funcs>(program);
+    }
+}
+
+// Usage: vm_bench [rounds]
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        ROUNDS = std::max(1, std::atoi(argv[1]));
+    }
+
+    std::printf("# hw3 bytecode VM and JIT against an AST walk, best of %d rounds\n", ROUNDS);
+    std::printf("program\tast_ns\tcompile_ns\tvm_ns\tjit_compile_ns\tjit_ns\tspeedup\tjit_speedup\tsame_output\n");
+    for (const Program &program : corpus()) {
+        SourceBuffer source;
+        std::copy(program.text.begin(), program.text.end(), source.allocate(program.text.size()));
+        ast::Arena arena;
+        SemanticAnalayzerVisitor visitor(false);
+        ast::Funcs *root = analyze(source, arena, visitor);
+        std::ostringstream ast_out;
+        std::ostringstream vm_out;
+        std::ostringstream jit_out;
+
+        double walk = best([&] { ast_out.str(std::string()); }, [&] { AstInterpreter(*root, ast_out).run(); });
+        vm::Program bytecode;
+        double lowering = best([&] {}, [&] {
+            BytecodeCompiler compiler;
+            root->accept(compiler);
+            bytecode = std::move(compiler.program);
+        });
+        double run = best([&] { vm_out.str(std::string()); }, [&] { vm::VirtualMachine(bytecode).run(vm_out); });
+        double translation = best([&] {}, [&] { vm::Jit jit(bytecode); });
+        vm::Jit jit(bytecode);
+        double native = best([&] { jit_out.str(std::string()); }, [&] { jit.run(jit_out); });
+
+        bool same = ast_out.str() == vm_out.str() && ast_out.str() == jit_out.str();
+        std::printf("%s\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\t%.2f\t%.2f\t%s\n", program.name, walk, lowering, run,
+                    translation, native, walk / run, walk / native, same ? "yes" : "NO");
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "bytecode.hpp"
+
+namespace vm {
+
+    static const char *const OPCODE_NAMES[] = {
+#define VM_OPCODE_NAME(name, operands) #name,
+            VM_OPCODES(VM_OPCODE_NAME)
+#undef VM_OPCODE_NAME
+    };
+
+    static const int OPCODE_OPERANDS[] = {
+#define VM_OPCODE_OPERANDS(name, operands) operands,
+            VM_OPCODES(VM_OPCODE_OPERANDS)
+#undef VM_OPCODE_OPERANDS
+    };
+
+    const char *opcodeName(Opcode opcode) {
+        return OPCODE_NAMES[opcode];
+    }
+
+    int operandCount(Opcode opcode) {
+        return OPCODE_OPERANDS[opcode];
+    }
+
+    int stackEffect(Opcode opcode) {
+        switch (opcode) {
+            case PUSH:
+            case LOAD:
+                return 1;
+            case LOAD2:
+                return 2;
+            case STORE:
+            case POP:
+            case ADD:
+            case SUB:
+            case MUL:
+            case DIV:
+            case EQ:
+            case NE:
+            case LT:
+            case GT:
+            case LE:
+            case GE:
+            case JUMP_IF_FALSE:
+            case JUMP_IF_TRUE:
+            case RET_VALUE:
+            case PRINTI:
+                return -1;
+            case JUMP_UNLESS_EQ:
+            case JUMP_UNLESS_NE:
+            case JUMP_UNLESS_LT:
+            case JUMP_UNLESS_GT:
+            case JUMP_UNLESS_LE:
+            case JUMP_UNLESS_GE:
+                return -2;
+            default:
+                return 0;
+        }
+    }
+
+    size_t Program::end(const Function &function) const {
+        size_t end = code.size();
+        for (const Function &other : functions) {
+            if (other.entry > function.entry && static_cast<size_t>(other.entry) < end) {
+                end = other.entry;
+            }
+        }
+        return end;
+    }
+
+    void Program::disassemble(std::ostream &os) const {
+        for (const Function &function : functions) {
+            size_t end = this->end(function);
+            os << function.name << ": params " << function.params << ", frame " << function.frame_size
+               << ", stack " << function.max_stack << std::endl;
+            for (size_t pc = function.entry; pc < end;) {
+                Opcode opcode = static_cast<Opcode>(code[pc]);
+                os << "  " << pc << "\t" << opcodeName(opcode);
+                for (int i = 1; i <= operandCount(opcode); ++i) {
+                    os << (i == 1 ? " " : ", ") << code[pc + i];
+                }
+                if (opcode == PRINT) {
+                    os << "\t; \"" << strings[code[pc + 1]] << "\"";
+                } else if (opcode == CALL) {
+                    os << "\t; " << functions[code[pc + 1]].name;
+                }
+                os << std::endl;
+                pc += 1 + operandCount(opcode);
+            }
+        }
+    }
+}
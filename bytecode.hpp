@@ -0,0 +1,99 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vm {
+
+    /* Instructions of the virtual machine, with the number of operands that follow each of them in the code.
+     * The machine has a stack of int32 values: the locals of every active call, each frame followed by the operands
+     * of its expressions. Bools are 0 or 1, and bytes are kept between 0 and 255.
+     * The superinstructions at the end replace the sequences the compiler emits most, in a single dispatch.
+     */
+#define VM_OPCODES(OP)                                                                                               \
+    OP(PUSH, 1)            /* push the operand */                                                                  \
+    OP(LOAD, 1)            /* push the local in the slot */                                                        \
+    OP(STORE, 1)           /* pop into the local in the slot */                                                    \
+    OP(POP, 0)             /* drop the top value */                                                                \
+    OP(ADD, 0)             /* int arithmetic on the two top values, wrapping at 32 bits */                         \
+    OP(SUB, 0)                                                                                                       \
+    OP(MUL, 0)                                                                                                       \
+    OP(DIV, 0)             /* stops the program on a division by zero */                                           \
+    OP(TRUNC, 0)           /* wrap the top value to a byte */                                                      \
+    OP(EQ, 0)              /* compare the two top values */                                                        \
+    OP(NE, 0)                                                                                                        \
+    OP(LT, 0)                                                                                                        \
+    OP(GT, 0)                                                                                                        \
+    OP(LE, 0)                                                                                                        \
+    OP(GE, 0)                                                                                                        \
+    OP(NOT, 0)                                                                                                       \
+    OP(JUMP, 1)            /* jump to the operand */                                                               \
+    OP(JUMP_IF_FALSE, 1)   /* pop, and jump to the operand if the value is 0 */                                    \
+    OP(JUMP_IF_TRUE, 1)                                                                                              \
+    OP(CALL, 1)            /* call the function of the operand on the arguments at the top of the stack */         \
+    OP(RET, 0)             /* return from a void function */                                                       \
+    OP(RET_VALUE, 0)       /* return the top value */                                                              \
+    OP(PRINT, 1)           /* print the string of the operand */                                                   \
+    OP(PRINTI, 0)          /* pop and print the value */                                                           \
+    OP(HALT, 0)                                                                                                      \
+    OP(LOAD2, 2)           /* LOAD a, LOAD b */                                                                    \
+    OP(ADD_CONST, 1)       /* PUSH k, ADD (SUB is emitted as the opposite constant) */                             \
+    OP(INC_LOCAL, 2)       /* LOAD x, ADD_CONST k, STORE x */                                                      \
+    OP(JUMP_UNLESS_EQ, 1)  /* EQ, JUMP_IF_FALSE, and the same for the other comparisons */                         \
+    OP(JUMP_UNLESS_NE, 1)                                                                                            \
+    OP(JUMP_UNLESS_LT, 1)                                                                                            \
+    OP(JUMP_UNLESS_GT, 1)                                                                                            \
+    OP(JUMP_UNLESS_LE, 1)                                                                                            \
+    OP(JUMP_UNLESS_GE, 1)
+
+    enum Opcode : int32_t {
+#define VM_OPCODE_ENUM(name, operands) name,
+        VM_OPCODES(VM_OPCODE_ENUM)
+#undef VM_OPCODE_ENUM
+        OPCODE_COUNT
+    };
+
+    // Name of the opcode, as written in the listings
+    const char *opcodeName(Opcode opcode);
+
+    // Number of operands that follow the opcode
+    int operandCount(Opcode opcode);
+
+    // How many values the instruction pushes, minus how many it pops. CALL depends on the function and is not here
+    int stackEffect(Opcode opcode);
+
+    /* A compiled function */
+    struct Function {
+        std::string name;
+        // Index of its first instruction in Program::code
+        int32_t entry;
+        // Its arguments take the first slots of the frame, its locals the next ones
+        int32_t params;
+        int32_t frame_size;
+        // Most operands it keeps on the stack above its frame at once
+        int32_t max_stack;
+        bool returns_value;
+    };
+
+    /* A compiled program: the code of all of its functions, one after the other */
+    struct Program {
+        std::vector<int32_t> code;
+        std::vector<Function> functions;
+        // Literals of the print calls
+        std::vector<std::string> strings;
+        // Index of main in `functions`
+        int32_t main = -1;
+
+        // One past the last instruction of the function
+        size_t end(const Function &function) const;
+
+        // Prints the code, one instruction per line, under the name of each function
+        void disassemble(std::ostream &os) const;
+    };
+}
+
+#endif //BYTECODE_HPP
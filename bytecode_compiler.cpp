@@ -0,0 +1,451 @@
+#include <algorithm>
+#include <limits>
+
+#include "bytecode_compiler.hpp"
+
+/* Helper functions */
+
+// Start of an instruction that cannot fuse: there is none
+static const size_t NO_INSTRUCTION = std::numeric_limits<size_t>::max();
+
+// Comparison instruction of the relational operation
+static vm::Opcode comparison(ast::RelOpType op) {
+    switch (op) {
+        case ast::RelOpType::EQ:
+            return vm::EQ;
+        case ast::RelOpType::NE:
+            return vm::NE;
+        case ast::RelOpType::LT:
+            return vm::LT;
+        case ast::RelOpType::GT:
+            return vm::GT;
+        case ast::RelOpType::LE:
+            return vm::LE;
+        default:
+            return vm::GE;
+    }
+}
+
+// Comparison that is true exactly when the given one is false
+static vm::Opcode negated(vm::Opcode opcode) {
+    switch (opcode) {
+        case vm::EQ:
+            return vm::NE;
+        case vm::NE:
+            return vm::EQ;
+        case vm::LT:
+            return vm::GE;
+        case vm::GT:
+            return vm::LE;
+        case vm::LE:
+            return vm::GT;
+        default:
+            return vm::LT;
+    }
+}
+
+/* BytecodeCompiler class */
+
+BytecodeCompiler::BytecodeCompiler()
+        : function(nullptr), depth(0), last(NO_INSTRUCTION), before_last(NO_INSTRUCTION), barrier(0),
+          type(ast::BuiltInType::VOID), print_name(StringInterner::global().intern("print")),
+          printi_name(StringInterner::global().intern("printi")) {}
+
+void BytecodeCompiler::adjustDepth(int delta) {
+    depth += delta;
+    function->max_stack = std::max(function->max_stack, depth);
+}
+
+void BytecodeCompiler::append(vm::Opcode opcode, int32_t a, int32_t b) {
+    std::vector<int32_t> &code = program.code;
+    before_last = last;
+    last = code.size();
+    code.push_back(opcode);
+    int operands = vm::operandCount(opcode);
+    if (operands > 0) {
+        code.push_back(a);
+    }
+    if (operands > 1) {
+        code.push_back(b);
+    }
+}
+
+void BytecodeCompiler::emit(vm::Opcode opcode, int32_t a, int32_t b) {
+    std::vector<int32_t> &code = program.code;
+    int32_t *previous = last != NO_INSTRUCTION && barrier <= last ? &code[last] : nullptr;
+
+    switch (opcode) {
+        case vm::LOAD:
+            if (previous && *previous == vm::LOAD) {
+                *previous = vm::LOAD2;
+                code.push_back(a);
+                adjustDepth(1);
+                return;
+            }
+            break;
+        case vm::ADD:
+        case vm::SUB:
+            if (previous && *previous == vm::PUSH) {
+                *previous = vm::ADD_CONST;
+                if (opcode == vm::SUB) {
+                    // Negated with the same 32-bit wrap as the subtraction
+                    code[last + 1] = static_cast<int32_t>(0u - static_cast<uint32_t>(code[last + 1]));
+                }
+                adjustDepth(-1);
+                return;
+            }
+            break;
+        case vm::STORE:
+            if (previous && *previous == vm::ADD_CONST && before_last != NO_INSTRUCTION && barrier <= before_last &&
+                code[before_last] == vm::LOAD && code[before_last + 1] == a) {
+                int32_t constant = code[last + 1];
+                code.resize(before_last);
+                last = NO_INSTRUCTION;
+                append(vm::INC_LOCAL, a, constant);
+                adjustDepth(-1);
+                return;
+            }
+            break;
+        case vm::JUMP_IF_FALSE:
+            if (previous && *previous >= vm::EQ && *previous <= vm::GE) {
+                *previous = vm::JUMP_UNLESS_EQ + (*previous - vm::EQ);
+                code.push_back(a);
+                adjustDepth(-1);
+                return;
+            }
+            break;
+        case vm::CALL: {
+            const vm::Function &callee = program.functions[a];
+            append(opcode, a, b);
+            adjustDepth(-callee.params + (callee.returns_value ? 1 : 0));
+            return;
+        }
+        default:
+            break;
+    }
+    append(opcode, a, b);
+    adjustDepth(vm::stackEffect(opcode));
+}
+
+size_t BytecodeCompiler::emitJump(vm::Opcode opcode) {
+    emit(opcode, -1);
+    return program.code.size() - 1;
+}
+
+void BytecodeCompiler::bind(const std::vector<size_t> &jumps) {
+    if (jumps.empty()) {
+        return;
+    }
+    for (size_t jump : jumps) {
+        program.code[jump] = static_cast<int32_t>(program.code.size());
+    }
+    barrier = program.code.size();
+}
+
+int32_t BytecodeCompiler::label() {
+    barrier = program.code.size();
+    return static_cast<int32_t>(barrier);
+}
+
+ast::BuiltInType BytecodeCompiler::compileExp(ast::Exp *exp) {
+    exp->accept(*this);
+    return type;
+}
+
+void BytecodeCompiler::compileStatement(ast::Statement *statement) {
+    statement->accept(*this);
+    if (ast::isa<ast::Call>(statement) && type != ast::BuiltInType::VOID) {
+        emit(vm::POP);
+    }
+}
+
+void BytecodeCompiler::compileCondition(ast::Exp *condition, bool jump_when, std::vector<size_t> &jumps) {
+    switch (condition->kind) {
+        case ast::NodeKind::Bool:
+            if (ast::cast<ast::Bool>(condition)->value == jump_when) {
+                jumps.push_back(emitJump(vm::JUMP));
+            }
+            return;
+        case ast::NodeKind::Not:
+            compileCondition(ast::cast<ast::Not>(condition)->exp, !jump_when, jumps);
+            return;
+        case ast::NodeKind::And: {
+            auto and_node = ast::cast<ast::And>(condition);
+            if (!jump_when) {
+                compileCondition(and_node->left, false, jumps);
+                compileCondition(and_node->right, false, jumps);
+            } else {
+                std::vector<size_t> left_false;
+                compileCondition(and_node->left, false, left_false);
+                compileCondition(and_node->right, true, jumps);
+                bind(left_false);
+            }
+            return;
+        }
+        case ast::NodeKind::Or: {
+            auto or_node = ast::cast<ast::Or>(condition);
+            if (jump_when) {
+                compileCondition(or_node->left, true, jumps);
+                compileCondition(or_node->right, true, jumps);
+            } else {
+                std::vector<size_t> left_true;
+                compileCondition(or_node->left, true, left_true);
+                compileCondition(or_node->right, false, jumps);
+                bind(left_true);
+            }
+            return;
+        }
+        case ast::NodeKind::RelOp: {
+            // Jumping when the comparison holds is jumping unless its negation holds
+            auto rel_op = ast::cast<ast::RelOp>(condition);
+            compileExp(rel_op->left);
+            compileExp(rel_op->right);
+            vm::Opcode opcode = comparison(rel_op->op);
+            emit(jump_when ? negated(opcode) : opcode);
+            jumps.push_back(emitJump(vm::JUMP_IF_FALSE));
+            return;
+        }
+        default:
+            compileExp(condition);
+            jumps.push_back(emitJump(jump_when ? vm::JUMP_IF_TRUE : vm::JUMP_IF_FALSE));
+            return;
+    }
+}
+
+void BytecodeCompiler::compileBoolValue(ast::Exp *exp) {
+    std::vector<size_t> false_jumps;
+    compileCondition(exp, false, false_jumps);
+    emit(vm::PUSH, 1);
+    if (!false_jumps.empty()) {
+        size_t end = emitJump(vm::JUMP);
+        bind(false_jumps);
+        // Only one of the two values is pushed
+        adjustDepth(-1);
+        emit(vm::PUSH, 0);
+        bind({end});
+    }
+    type = ast::BuiltInType::BOOL;
+}
+
+void BytecodeCompiler::visit(ast::Num &node) {
+    emit(vm::PUSH, node.value);
+    type = ast::BuiltInType::INT;
+}
+
+void BytecodeCompiler::visit(ast::NumB &node) {
+    emit(vm::PUSH, node.value);
+    type = ast::BuiltInType::BYTE;
+}
+
+// Strings are only passed to print, which takes them from the string table
+void BytecodeCompiler::visit(ast::String &node) {
+    type = ast::BuiltInType::STRING;
+}
+
+void BytecodeCompiler::visit(ast::Bool &node) {
+    emit(vm::PUSH, node.value);
+    type = ast::BuiltInType::BOOL;
+}
+
+void BytecodeCompiler::visit(ast::ID &node) {
+    emit(vm::LOAD, slots.at(node.variable));
+    type = node.variable->type;
+}
+
+void BytecodeCompiler::visit(ast::BinOp &node) {
+    ast::BuiltInType left = compileExp(node.left);
+    ast::BuiltInType right = compileExp(node.right);
+    switch (node.op) {
+        case ast::BinOpType::ADD:
+            emit(vm::ADD);
+            break;
+        case ast::BinOpType::SUB:
+            emit(vm::SUB);
+            break;
+        case ast::BinOpType::MUL:
+            emit(vm::MUL);
+            break;
+        case ast::BinOpType::DIV:
+            emit(vm::DIV);
+            break;
+    }
+    bool is_byte = left == ast::BuiltInType::BYTE && right == ast::BuiltInType::BYTE;
+    // The quotient of two bytes is a byte already
+    if (is_byte && node.op != ast::BinOpType::DIV) {
+        emit(vm::TRUNC);
+    }
+    type = is_byte ? ast::BuiltInType::BYTE : ast::BuiltInType::INT;
+}
+
+void BytecodeCompiler::visit(ast::RelOp &node) {
+    compileExp(node.left);
+    compileExp(node.right);
+    emit(comparison(node.op));
+    type = ast::BuiltInType::BOOL;
+}
+
+void BytecodeCompiler::visit(ast::Not &node) {
+    compileExp(node.exp);
+    emit(vm::NOT);
+    type = ast::BuiltInType::BOOL;
+}
+
+void BytecodeCompiler::visit(ast::And &node) {
+    compileBoolValue(&node);
+}
+
+void BytecodeCompiler::visit(ast::Or &node) {
+    compileBoolValue(&node);
+}
+
+void BytecodeCompiler::visit(ast::Type &node) {}
+
+void BytecodeCompiler::visit(ast::Cast &node) {
+    ast::BuiltInType from = compileExp(node.exp);
+    if (node.target_type->type == ast::BuiltInType::BYTE && from != ast::BuiltInType::BYTE) {
+        emit(vm::TRUNC);
+    }
+    type = node.target_type->type;
+}
+
+void BytecodeCompiler::visit(ast::ExpList &node) {
+    for (ast::Exp *exp : node.exps) {
+        compileExp(exp);
+    }
+}
+
+void BytecodeCompiler::visit(ast::Call &node) {
+    Symbol name = node.func_id->name;
+    if (name == print_name) {
+        program.strings.emplace_back(ast::cast<ast::String>(node.args->exps[0])->value);
+        emit(vm::PRINT, static_cast<int32_t>(program.strings.size() - 1));
+    } else if (name == printi_name) {
+        compileExp(node.args->exps[0]);
+        emit(vm::PRINTI);
+    } else {
+        node.args->accept(*this);
+        emit(vm::CALL, functions.at(name));
+    }
+    type = node.func_id->function->return_type;
+}
+
+void BytecodeCompiler::visit(ast::Statements &node) {
+    for (ast::Statement *statement : node.statements) {
+        compileStatement(statement);
+    }
+}
+
+void BytecodeCompiler::visit(ast::Break &node) {
+    loops.back().breaks.push_back(emitJump(vm::JUMP));
+}
+
+void BytecodeCompiler::visit(ast::Continue &node) {
+    emit(vm::JUMP, loops.back().start);
+}
+
+void BytecodeCompiler::visit(ast::Return &node) {
+    if (node.exp) {
+        compileExp(node.exp);
+        emit(vm::RET_VALUE);
+    } else {
+        emit(vm::RET);
+    }
+}
+
+void BytecodeCompiler::visit(ast::If &node) {
+    std::vector<size_t> false_jumps;
+    compileCondition(node.condition, false, false_jumps);
+    compileStatement(node.then);
+    if (node.otherwise) {
+        size_t end = emitJump(vm::JUMP);
+        bind(false_jumps);
+        compileStatement(node.otherwise);
+        bind({end});
+    } else {
+        bind(false_jumps);
+    }
+}
+
+void BytecodeCompiler::visit(ast::While &node) {
+    loops.push_back({label(), {}});
+
+    std::vector<size_t> exits;
+    compileCondition(node.condition, false, exits);
+    compileStatement(node.body);
+    emit(vm::JUMP, loops.back().start);
+    exits.insert(exits.end(), loops.back().breaks.begin(), loops.back().breaks.end());
+    bind(exits);
+
+    loops.pop_back();
+}
+
+void BytecodeCompiler::visit(ast::VarDecl &node) {
+    if (node.init_exp) {
+        compileExp(node.init_exp);
+    } else {
+        emit(vm::PUSH, 0);
+    }
+
+    int32_t slot = function->params + layout.slot(node.id->variable);
+    slots[node.id->variable] = slot;
+    emit(vm::STORE, slot);
+}
+
+void BytecodeCompiler::visit(ast::Assign &node) {
+    compileExp(node.exp);
+    emit(vm::STORE, slots.at(node.id->variable));
+}
+
+void BytecodeCompiler::visit(ast::Formal &node) {}
+
+void BytecodeCompiler::visit(ast::Formals &node) {}
+
+void BytecodeCompiler::visit(ast::FuncDecl &node) {
+    function = &program.functions[functions.at(node.id->name)];
+    function->entry = static_cast<int32_t>(program.code.size());
+    last = before_last = NO_INSTRUCTION;
+    barrier = program.code.size();
+    depth = 0;
+    slots.clear();
+
+    // The arguments, at offsets -1, -2, ..., come first in the frame
+    for (size_t i = 0; i < node.formals->formals.size(); ++i) {
+        slots[node.formals->formals[i]->id->variable] = static_cast<int32_t>(i);
+    }
+    node.body->accept(*this);
+
+    // Falling off the end of a function returns 0, or nothing
+    if (function->returns_value) {
+        emit(vm::PUSH, 0);
+        emit(vm::RET_VALUE);
+    } else {
+        emit(vm::RET);
+    }
+}
+
+void BytecodeCompiler::visit(ast::Funcs &node) {
+    node.accept(layout);
+    program.functions.reserve(node.funcs.size());
+    for (size_t i = 0; i < node.funcs.size(); ++i) {
+        ast::FuncDecl *func = node.funcs[i];
+        int32_t params = static_cast<int32_t>(func->formals->formals.size());
+        int32_t frame_size = params + layout.frames[i].frame_size;
+        bool returns_value = func->return_type->type != ast::BuiltInType::VOID;
+        functions[func->id->name] = static_cast<int32_t>(program.functions.size());
+        program.functions.push_back({func->id->text(), -1, params, frame_size, 0, returns_value});
+        if (func->id->text() == "main") {
+            program.main = static_cast<int32_t>(program.functions.size() - 1);
+        }
+    }
+
+    // The program starts by calling main, and stops when main returns
+    vm::Function start = {"start", 0, 0, 0, 0, false};
+    function = &start;
+    emit(vm::CALL, program.main);
+    emit(vm::HALT);
+
+    for (ast::FuncDecl *func : node.funcs) {
+        func->accept(*this);
+    }
+    function = nullptr;
+}
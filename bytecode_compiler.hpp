@@ -0,0 +1,137 @@
+#ifndef BYTECODE_COMPILER_HPP
+#define BYTECODE_COMPILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "symbol_table.hpp"
+#include "bytecode.hpp"
+#include "frame_layout.hpp"
+
+/* BytecodeCompiler class
+ * Lowers an analyzed program to the bytecode of the virtual machine (see virtual_machine.hpp). The program must have
+ * been analyzed without errors, and not through a FunctionCache: the identifiers of a cached body are not bound.
+ * Every local gets the slot the FrameLayout gave it, after the arguments, so the locals of sibling scopes share their
+ * slots.
+ * Conditions compile to jumps, and a few instruction pairs fuse into superinstructions as they are emitted.
+ */
+class BytecodeCompiler : public Visitor {
+public:
+    BytecodeCompiler();
+
+    void visit(ast::Num &node) override;
+
+    void visit(ast::NumB &node) override;
+
+    void visit(ast::String &node) override;
+
+    void visit(ast::Bool &node) override;
+
+    void visit(ast::ID &node) override;
+
+    void visit(ast::BinOp &node) override;
+
+    void visit(ast::RelOp &node) override;
+
+    void visit(ast::Not &node) override;
+
+    void visit(ast::And &node) override;
+
+    void visit(ast::Or &node) override;
+
+    void visit(ast::Type &node) override;
+
+    void visit(ast::Cast &node) override;
+
+    void visit(ast::ExpList &node) override;
+
+    void visit(ast::Call &node) override;
+
+    void visit(ast::Statements &node) override;
+
+    void visit(ast::Break &node) override;
+
+    void visit(ast::Continue &node) override;
+
+    void visit(ast::Return &node) override;
+
+    void visit(ast::If &node) override;
+
+    void visit(ast::While &node) override;
+
+    void visit(ast::VarDecl &node) override;
+
+    void visit(ast::Assign &node) override;
+
+    void visit(ast::Formal &node) override;
+
+    void visit(ast::Formals &node) override;
+
+    void visit(ast::FuncDecl &node) override;
+
+    void visit(ast::Funcs &node) override;
+
+    // The compiled program, once a Funcs node is visited
+    vm::Program program;
+
+private:
+    // A loop being compiled
+    struct Loop {
+        int32_t start;
+        // Operands of its breaks, bound to the end of the loop
+        std::vector<size_t> breaks;
+    };
+
+    // Compiles the expression, which pushes its value. Returns its type
+    ast::BuiltInType compileExp(ast::Exp *exp);
+
+    // Compiles the statement, dropping the value of a call
+    void compileStatement(ast::Statement *statement);
+
+    // Compiles a jump taken when the condition evaluates to `jump_when`, which falls through otherwise. The operands
+    // of its jumps are added to `jumps`
+    void compileCondition(ast::Exp *condition, bool jump_when, std::vector<size_t> &jumps);
+
+    // Compiles a boolean operation as a value: 1 or 0
+    void compileBoolValue(ast::Exp *exp);
+
+    // Appends the instruction, fusing it with the previous ones when they form a superinstruction
+    void emit(vm::Opcode opcode, int32_t a = 0, int32_t b = 0);
+
+    // Appends a jump to a target not known yet, and returns the index of its operand
+    size_t emitJump(vm::Opcode opcode);
+
+    // Binds the jumps to the next instruction, or marks the next instruction as a jump target
+    void bind(const std::vector<size_t> &jumps);
+
+    int32_t label();
+
+    // Appends a new instruction, without fusing it
+    void append(vm::Opcode opcode, int32_t a, int32_t b);
+
+    // Moves the operand stack depth by `delta`, keeping the highest
+    void adjustDepth(int delta);
+
+    // User functions and slots of the variables in the function being compiled
+    std::unordered_map<Symbol, int32_t> functions;
+    std::unordered_map<const SymbolEntry *, int32_t> slots;
+    FrameLayout layout;
+    std::vector<Loop> loops;
+    vm::Function *function;
+    int32_t depth;
+    // Start of the last two instructions, which may fuse with the next one, and the last jump target. Instructions
+    // on both sides of a jump target never fuse
+    size_t last;
+    size_t before_last;
+    size_t barrier;
+    // Type of the last compiled expression
+    ast::BuiltInType type;
+    Symbol print_name;
+    Symbol printi_name;
+};
+
+#endif //BYTECODE_COMPILER_HPP
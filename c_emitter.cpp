@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "c_emitter.hpp"
+
+/* Helper functions */
+
+// Runtime of the emitted programs: the builtins, and the int arithmetic of FanC
+static const char *const RUNTIME =
+        "#include <stdint.h>\n"
+        "#include <stdio.h>\n"
+        "#include <stdlib.h>\n"
+        "\n"
+        "static void fanc_print(const char *string) {\n"
+        "    printf(\"%s\\n\", string);\n"
+        "}\n"
+        "\n"
+        "static void fanc_printi(int32_t value) {\n"
+        "    printf(\"%d\\n\", value);\n"
+        "}\n"
+        "\n"
+        "static int32_t fanc_add(int32_t a, int32_t b) {\n"
+        "    return (int32_t) ((uint32_t) a + (uint32_t) b);\n"
+        "}\n"
+        "\n"
+        "static int32_t fanc_sub(int32_t a, int32_t b) {\n"
+        "    return (int32_t) ((uint32_t) a - (uint32_t) b);\n"
+        "}\n"
+        "\n"
+        "static int32_t fanc_mul(int32_t a, int32_t b) {\n"
+        "    return (int32_t) ((uint32_t) a * (uint32_t) b);\n"
+        "}\n"
+        "\n"
+        "static int32_t fanc_div(int32_t a, int32_t b) {\n"
+        "    if (b == 0) {\n"
+        "        printf(\"Error division by zero\\n\");\n"
+        "        exit(0);\n"
+        "    }\n"
+        "    /* INT_MIN / -1 overflows, and wraps back to INT_MIN */\n"
+        "    return b == -1 ? fanc_sub(0, a) : a / b;\n"
+        "}\n";
+
+// C name of a user function, apart from the runtime and from the C main
+static std::string functionName(const ast::ID &id) {
+    return "f_" + id.text();
+}
+
+// C literal of the string: the characters of the source, printed as they are
+static std::string stringLiteral(std::string_view value) {
+    std::string literal = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+            literal += c;
+        } else if (c < ' ' || c > '~' || c == '?') {
+            // In octal, so that neither the next character nor a trigraph changes it
+            char escape[5];
+            std::snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c));
+            literal += escape;
+        } else {
+            literal += c;
+        }
+    }
+    return literal + "\"";
+}
+
+static const char *binaryOperator(ast::BinOpType op) {
+    switch (op) {
+        case ast::BinOpType::ADD:
+            return "+";
+        case ast::BinOpType::SUB:
+            return "-";
+        case ast::BinOpType::MUL:
+            return "*";
+        default:
+            return "/";
+    }
+}
+
+static const char *relationalOperator(ast::RelOpType op) {
+    switch (op) {
+        case ast::RelOpType::EQ:
+            return "==";
+        case ast::RelOpType::NE:
+            return "!=";
+        case ast::RelOpType::LT:
+            return "<";
+        case ast::RelOpType::GT:
+            return ">";
+        case ast::RelOpType::LE:
+            return "<=";
+        default:
+            return ">=";
+    }
+}
+
+static const char *runtimeFunction(ast::BinOpType op) {
+    switch (op) {
+        case ast::BinOpType::ADD:
+            return "fanc_add";
+        case ast::BinOpType::SUB:
+            return "fanc_sub";
+        case ast::BinOpType::MUL:
+            return "fanc_mul";
+        default:
+            return "fanc_div";
+    }
+}
+
+CEmitter::CEmitter(std::ostream &out)
+        : out(out), indent(0), temporaries(0), declared_temporaries(0), has_call(false), type(ast::BuiltInType::VOID),
+          print_name(StringInterner::global().intern("print")),
+          printi_name(StringInterner::global().intern("printi")) {}
+
+std::string CEmitter::expression(ast::Exp *exp) {
+    exp->accept(*this);
+    return code;
+}
+
+std::string CEmitter::condition(ast::Exp *exp) {
+    std::string condition = expression(exp);
+    // Comparisons and logical operations are in parentheses already
+    if (ast::isa<ast::RelOp>(exp) || ast::isa<ast::And>(exp) || ast::isa<ast::Or>(exp)) {
+        return condition.substr(1, condition.size() - 2);
+    }
+    return condition;
+}
+
+std::string CEmitter::sequence(std::vector<std::string> &operands, const std::vector<bool> &calls) {
+    if (std::count(calls.begin(), calls.end(), true) < 2) {
+        return "";
+    }
+    std::string assignments;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        if (calls[i]) {
+            std::string temporary = "t" + std::to_string(temporaries++);
+            assignments += temporary + " = " + operands[i] + ", ";
+            operands[i] = temporary;
+        }
+    }
+    return assignments;
+}
+
+void CEmitter::declareTemporaries() {
+    if (declared_temporaries == temporaries) {
+        return;
+    }
+    line() << "int32_t ";
+    for (int i = declared_temporaries; i < temporaries; ++i) {
+        out << (i > declared_temporaries ? ", t" : "t") << i;
+    }
+    out << ";" << std::endl;
+    declared_temporaries = temporaries;
+}
+
+void CEmitter::statement(ast::Statement *statement) {
+    statement->accept(*this);
+    if (ast::isa<ast::Call>(statement)) {
+        declareTemporaries();
+        line() << code << ";" << std::endl;
+    }
+}
+
+void CEmitter::body(ast::Statement *statement) {
+    out << " {" << std::endl;
+    ++indent;
+    if (ast::Statements *statements = ast::dyn_cast<ast::Statements>(statement)) {
+        for (ast::Statement *inner : statements->statements) {
+            this->statement(inner);
+        }
+    } else {
+        this->statement(statement);
+    }
+    --indent;
+    line() << "}";
+}
+
+std::ostream &CEmitter::line() {
+    for (int i = 0; i < indent; ++i) {
+        out << "    ";
+    }
+    return out;
+}
+
+void CEmitter::signature(const ast::FuncDecl &function) {
+    out << "static " << (function.return_type->type == ast::BuiltInType::VOID ? "void " : "int32_t ")
+        << functionName(*function.id) << "(";
+    for (size_t i = 0; i < function.formals->formals.size(); ++i) {
+        out << (i ? ", " : "") << "int32_t p" << i;
+    }
+    out << (function.formals->formals.empty() ? "void)" : ")");
+}
+
+void CEmitter::visit(ast::Num &node) {
+    // INT_MIN has no literal of its own in C
+    code = node.value == INT32_MIN ? "INT32_MIN" : std::to_string(node.value);
+    has_call = false;
+    type = ast::BuiltInType::INT;
+}
+
+void CEmitter::visit(ast::NumB &node) {
+    code = std::to_string(node.value);
+    has_call = false;
+    type = ast::BuiltInType::BYTE;
+}
+
+void CEmitter::visit(ast::String &node) {
+    code = stringLiteral(node.value);
+    has_call = false;
+    type = ast::BuiltInType::STRING;
+}
+
+void CEmitter::visit(ast::Bool &node) {
+    code = node.value ? "1" : "0";
+    has_call = false;
+    type = ast::BuiltInType::BOOL;
+}
+
+void CEmitter::visit(ast::ID &node) {
+    code = names.at(node.variable);
+    has_call = false;
+    type = node.variable->type;
+}
+
+void CEmitter::visit(ast::BinOp &node) {
+    std::vector<std::string> operands = {expression(node.left)};
+    std::vector<bool> calls = {has_call};
+    ast::BuiltInType left_type = type;
+    operands.push_back(expression(node.right));
+    calls.push_back(has_call);
+    std::string assignments = sequence(operands, calls);
+    bool is_byte = left_type == ast::BuiltInType::BYTE && type == ast::BuiltInType::BYTE;
+    if (node.op == ast::BinOpType::DIV || !is_byte) {
+        // The quotient of two bytes is a byte already
+        code = std::string(runtimeFunction(node.op)) + "(" + operands[0] + ", " + operands[1] + ")";
+        if (!assignments.empty()) {
+            code = "(" + assignments + code + ")";
+        }
+    } else {
+        code = "((" + assignments + operands[0] + " " + binaryOperator(node.op) + " " + operands[1] + ") & 0xFF)";
+    }
+    has_call = calls[0] || calls[1];
+    type = is_byte ? ast::BuiltInType::BYTE : ast::BuiltInType::INT;
+}
+
+void CEmitter::visit(ast::RelOp &node) {
+    std::vector<std::string> operands = {expression(node.left)};
+    std::vector<bool> calls = {has_call};
+    operands.push_back(expression(node.right));
+    calls.push_back(has_call);
+    std::string assignments = sequence(operands, calls);
+    code = "(" + assignments + operands[0] + " " + relationalOperator(node.op) + " " + operands[1] + ")";
+    has_call = calls[0] || calls[1];
+    type = ast::BuiltInType::BOOL;
+}
+
+void CEmitter::visit(ast::Not &node) {
+    code = "!" + expression(node.exp);
+    type = ast::BuiltInType::BOOL;
+}
+
+void CEmitter::visit(ast::And &node) {
+    // && and || evaluate their operands in order already
+    std::string left = expression(node.left);
+    bool left_call = has_call;
+    code = "(" + left + " && " + expression(node.right) + ")";
+    has_call = has_call || left_call;
+    type = ast::BuiltInType::BOOL;
+}
+
+void CEmitter::visit(ast::Or &node) {
+    std::string left = expression(node.left);
+    bool left_call = has_call;
+    code = "(" + left + " || " + expression(node.right) + ")";
+    has_call = has_call || left_call;
+    type = ast::BuiltInType::BOOL;
+}
+
+void CEmitter::visit(ast::Type &node) {}
+
+void CEmitter::visit(ast::Cast &node) {
+    std::string exp = expression(node.exp);
+    if (node.target_type->type == ast::BuiltInType::BYTE && type != ast::BuiltInType::BYTE) {
+        code = "(" + exp + " & 0xFF)";
+    } else {
+        code = exp;
+    }
+    type = node.target_type->type;
+}
+
+void CEmitter::visit(ast::ExpList &node) {
+    std::string list;
+    for (size_t i = 0; i < node.exps.size(); ++i) {
+        list += (i ? ", " : "") + expression(node.exps[i]);
+    }
+    code = list;
+}
+
+void CEmitter::visit(ast::Call &node) {
+    Symbol name = node.func_id->name;
+    if (name == print_name) {
+        code = "fanc_print(" + expression(node.args->exps[0]) + ")";
+    } else if (name == printi_name) {
+        code = "fanc_printi(" + expression(node.args->exps[0]) + ")";
+    } else {
+        std::vector<std::string> operands;
+        std::vector<bool> calls;
+        for (ast::Exp *exp : node.args->exps) {
+            operands.push_back(expression(exp));
+            calls.push_back(has_call);
+        }
+        std::string assignments = sequence(operands, calls);
+        code = functionName(*node.func_id) + "(";
+        for (size_t i = 0; i < operands.size(); ++i) {
+            code += (i ? ", " : "") + operands[i];
+        }
+        code += ")";
+        if (!assignments.empty()) {
+            code = "(" + assignments + code + ")";
+        }
+    }
+    has_call = true;
+    type = node.func_id->function->return_type;
+}
+
+void CEmitter::visit(ast::Statements &node) {
+    line() << "{" << std::endl;
+    ++indent;
+    for (ast::Statement *statement : node.statements) {
+        this->statement(statement);
+    }
+    --indent;
+    line() << "}" << std::endl;
+}
+
+void CEmitter::visit(ast::Break &node) {
+    line() << "break;" << std::endl;
+}
+
+void CEmitter::visit(ast::Continue &node) {
+    line() << "continue;" << std::endl;
+}
+
+void CEmitter::visit(ast::Return &node) {
+    if (node.exp) {
+        std::string exp = expression(node.exp);
+        declareTemporaries();
+        line() << "return " << exp << ";" << std::endl;
+    } else {
+        line() << "return;" << std::endl;
+    }
+}
+
+void CEmitter::visit(ast::If &node) {
+    std::string condition = this->condition(node.condition);
+    declareTemporaries();
+    line() << "if (" << condition << ")";
+    body(node.then);
+    if (node.otherwise) {
+        out << " else";
+        body(node.otherwise);
+    }
+    out << std::endl;
+}
+
+void CEmitter::visit(ast::While &node) {
+    std::string condition = this->condition(node.condition);
+    // The offsets of the loop start at 0 again, so its locals come after those of the scope around it
+    const Level &outer = levels.back();
+    levels.push_back({outer.base + outer.next, 0});
+    declareTemporaries();
+    line() << "while (" << condition << ")";
+    body(node.body);
+    out << std::endl;
+    levels.pop_back();
+}
+
+void CEmitter::visit(ast::VarDecl &node) {
+    std::string init = node.init_exp ? expression(node.init_exp) : "0";
+    const SymbolEntry *variable = node.id->variable;
+    Level &level = levels.back();
+    std::string name = "l" + std::to_string(level.base + variable->offset);
+    level.next = std::max(level.next, variable->offset + 1);
+    names[variable] = name;
+    declareTemporaries();
+    line() << "int32_t " << name << " = " << init << ";" << std::endl;
+}
+
+void CEmitter::visit(ast::Assign &node) {
+    std::string exp = expression(node.exp);
+    declareTemporaries();
+    line() << names.at(node.id->variable) << " = " << exp << ";" << std::endl;
+}
+
+void CEmitter::visit(ast::Formal &node) {}
+
+void CEmitter::visit(ast::Formals &node) {}
+
+void CEmitter::visit(ast::FuncDecl &node) {
+    names.clear();
+    levels.assign(1, {0, 0});
+    temporaries = declared_temporaries = 0;
+    for (size_t i = 0; i < node.formals->formals.size(); ++i) {
+        names[node.formals->formals[i]->id->variable] = "p" + std::to_string(i);
+    }
+
+    out << std::endl;
+    signature(node);
+    out << " {" << std::endl;
+    indent = 1;
+    for (ast::Statement *statement : node.body->statements) {
+        this->statement(statement);
+    }
+    // Falling off the end of a function returns 0
+    if (node.return_type->type != ast::BuiltInType::VOID) {
+        line() << "return 0;" << std::endl;
+    }
+    indent = 0;
+    out << "}" << std::endl;
+}
+
+void CEmitter::visit(ast::Funcs &node) {
+    out << RUNTIME << std::endl;
+    for (ast::FuncDecl *func : node.funcs) {
+        signature(*func);
+        out << ";" << std::endl;
+    }
+    for (ast::FuncDecl *func : node.funcs) {
+        func->accept(*this);
+    }
+    out << std::endl << "int main(void) {" << std::endl;
+    out << "    f_main();" << std::endl;
+    out << "    return 0;" << std::endl;
+    out << "}" << std::endl;
+}
@@ -0,0 +1,130 @@
+#ifndef C_EMITTER_HPP
+#define C_EMITTER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "symbol_table.hpp"
+
+/* CEmitter class
+ * Translates an analyzed program to a C program, to be compiled by the system compiler. Like the BytecodeCompiler,
+ * it needs a program analyzed without errors and not through a FunctionCache.
+ * Every function becomes a C function, and every variable a C local named after its slot: the arguments are p0,
+ * p1, ..., and the locals l0, l1, ... after the offsets of the analyzer. Those start at 0 again in a while scope, so
+ * the emitter rebases the locals of a loop after the ones of the scope around it.
+ * All the values are int32_t. Int arithmetic goes through the small runtime printed first, which wraps at 32 bits
+ * and stops on a division by zero, and byte arithmetic is masked to 8 bits where it happens.
+ * C leaves the order of the operands of an operator or a call unspecified, so when more than one of them calls a
+ * function, they are evaluated left to right into temporaries t0, t1, ... in a comma expression.
+ */
+class CEmitter : public Visitor {
+public:
+    explicit CEmitter(std::ostream &out);
+
+    void visit(ast::Num &node) override;
+
+    void visit(ast::NumB &node) override;
+
+    void visit(ast::String &node) override;
+
+    void visit(ast::Bool &node) override;
+
+    void visit(ast::ID &node) override;
+
+    void visit(ast::BinOp &node) override;
+
+    void visit(ast::RelOp &node) override;
+
+    void visit(ast::Not &node) override;
+
+    void visit(ast::And &node) override;
+
+    void visit(ast::Or &node) override;
+
+    void visit(ast::Type &node) override;
+
+    void visit(ast::Cast &node) override;
+
+    void visit(ast::ExpList &node) override;
+
+    void visit(ast::Call &node) override;
+
+    void visit(ast::Statements &node) override;
+
+    void visit(ast::Break &node) override;
+
+    void visit(ast::Continue &node) override;
+
+    void visit(ast::Return &node) override;
+
+    void visit(ast::If &node) override;
+
+    void visit(ast::While &node) override;
+
+    void visit(ast::VarDecl &node) override;
+
+    void visit(ast::Assign &node) override;
+
+    void visit(ast::Formal &node) override;
+
+    void visit(ast::Formals &node) override;
+
+    void visit(ast::FuncDecl &node) override;
+
+    void visit(ast::Funcs &node) override;
+
+private:
+    // Offsets of the analyzer in one while scope (or in the function body), mapped to the locals `base` and on
+    struct Level {
+        int32_t base;
+        // One past the highest offset declared so far
+        int32_t next;
+    };
+
+    // C expression of the expression. Its type is left in `type`
+    std::string expression(ast::Exp *exp);
+
+    // Same, for the condition of an if or a while
+    std::string condition(ast::Exp *exp);
+
+    // Moves the operands that call a function to temporaries, when there are several of them, and returns the
+    // assignments that evaluate them in order, to put before the expression in a comma expression
+    std::string sequence(std::vector<std::string> &operands, const std::vector<bool> &calls);
+
+    // Declares the temporaries of the statement about to be written
+    void declareTemporaries();
+
+    // Writes the statement, with the call it may be
+    void statement(ast::Statement *statement);
+
+    // Writes the statement as the body of an if or a while, in braces
+    void body(ast::Statement *statement);
+
+    // Indentation of the current line
+    std::ostream &line();
+
+    // Prototype of the function
+    void signature(const ast::FuncDecl &function);
+
+    std::ostream &out;
+    // C names of the variables in the function being written
+    std::unordered_map<const SymbolEntry *, std::string> names;
+    std::vector<Level> levels;
+    int indent;
+    // Temporaries of the function being written, and how many of them are declared already
+    int temporaries;
+    int declared_temporaries;
+    // The last expression written, and whether it calls a function
+    std::string code;
+    bool has_call;
+    ast::BuiltInType type;
+    Symbol print_name;
+    Symbol printi_name;
+};
+
+#endif //C_EMITTER_HPP
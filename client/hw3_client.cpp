@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../server_protocol.hpp"
+
+/* Command line
+ *   hw3_client [--socket SOCKET] [--all-errors] [--check-only] < program
+ *   hw3_client [--socket SOCKET] [--all-errors] [--check-only] --input FILE
+ * Sends the program to a server started with `hw3 --serve SOCKET` and prints what hw3 would print for it, with
+ * the same exit status, so it can stand in for hw3. The socket defaults to $HW3_SOCKET, then to /tmp/hw3.sock.
+ */
+
+static void usage() {
+    std::cerr << "usage: hw3_client [--socket SOCKET] [--all-errors] [--check-only] < program" << std::endl;
+    std::cerr << "       hw3_client [--socket SOCKET] [--all-errors] [--check-only] --input FILE" << std::endl;
+    exit(1);
+}
+
+// Connects to the server, or returns -1
+static int connectTo(const std::string &path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    strcpy(address.sun_path, path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv) {
+    const char *environment = getenv("HW3_SOCKET");
+    std::string socket_path = environment ? environment : protocol::DEFAULT_SOCKET;
+    std::string input;
+    uint32_t flags = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--socket") && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (!strcmp(argv[i], "--all-errors")) {
+            flags |= protocol::ALL_ERRORS;
+        } else if (!strcmp(argv[i], "--check-only")) {
+            flags |= protocol::CHECK_ONLY;
+        } else if (!strcmp(argv[i], "--input") && i + 1 < argc) {
+            input = argv[++i];
+        } else {
+            usage();
+        }
+    }
+
+    std::string program;
+    if (input.empty()) {
+        program.assign(std::istreambuf_iterator<char>(std::cin), {});
+    } else {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            std::cerr << "hw3_client: cannot read " << input << std::endl;
+            return 1;
+        }
+        program.assign(std::istreambuf_iterator<char>(in), {});
+    }
+
+    if (program.size() > protocol::MAX_REQUEST_SIZE) {
+        std::cerr << "hw3_client: the program is larger than the server accepts (" << protocol::MAX_REQUEST_SIZE
+                  << " bytes)" << std::endl;
+        return 1;
+    }
+
+    int fd = connectTo(socket_path);
+    if (fd < 0) {
+        std::cerr << "hw3_client: cannot connect to " << socket_path << std::endl;
+        return 1;
+    }
+
+    protocol::RequestHeader request = {protocol::REQUEST_MAGIC, flags, program.size()};
+    protocol::ResponseHeader response;
+    std::string result;
+    bool ok = protocol::writeFully(fd, &request, sizeof(request)) &&
+              protocol::writeFully(fd, program.data(), program.size()) &&
+              protocol::readFully(fd, &response, sizeof(response)) && response.magic == protocol::RESPONSE_MAGIC;
+    if (ok) {
+        result.resize(response.size);
+        ok = protocol::readFully(fd, &result[0], result.size());
+    }
+    close(fd);
+    if (!ok) {
+        std::cerr << "hw3_client: the server at " << socket_path << " did not answer" << std::endl;
+        return 1;
+    }
+
+    if (response.status == protocol::REJECTED) {
+        std::cerr << result;
+        return 1;
+    }
+    std::cout << result;
+    return (flags & protocol::CHECK_ONLY) && response.status != 0 ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+#include <memory>
+
+#include "compilation.hpp"
+#include "output.hpp"
+#include "arena.hpp"
+#include "parse_context.hpp"
+#include "semantic_analayzer_visitor.hpp"
+#include "constant_folder.hpp"
+#include "dead_code_eliminator.hpp"
+#include "bytecode_compiler.hpp"
+#include "virtual_machine.hpp"
+#include "jit.hpp"
+#include "c_emitter.hpp"
+#include "ir_builder.hpp"
+#include "ssa_builder.hpp"
+#include "frame_layout.hpp"
+
+bool compile(SourceBuffer &source, std::ostream &out, const CompileOptions &options) {
+    ast::Arena arena;
+    return compile(source, arena, out, options);
+}
+
+bool compile(SourceBuffer &source, ast::Arena &arena, std::ostream &out, const CompileOptions &options) {
+    output::Diagnostics diagnostics(options.all_errors);
+    output::Diagnostics *previous = output::setDiagnostics(&diagnostics);
+
+    bool compiled;
+    {
+        // The program is run, listed or translated instead of its scopes
+        bool backend = options.run || options.dump_bytecode || options.jit || options.emit_c || options.dump_ir ||
+                       options.frame_layout;
+        // The folding and the backend need the identifiers bound by the analysis, which a cached body skips
+        FunctionCache *cache = options.fold || backend ? nullptr : options.cache;
+        SemanticAnalayzerVisitor visitor(!options.check_only && !backend, options.jobs, cache, options.time_report);
+        ast::Node *program = nullptr;
+        try {
+            {
+                TimeScope parse(options.time_report, "parse");
+                program = ast::parse(source, arena, options.time_report);
+            }
+            program->accept(visitor);
+            if (options.fold && diagnostics.empty()) {
+                TimeScope fold(options.time_report, "fold");
+                options.fold->nodes += ast::countNodes(program);
+                ConstantFolder folder(arena, *options.fold);
+                program->accept(folder);
+            }
+            if (options.eliminate_dead_code && diagnostics.empty()) {
+                TimeScope eliminate(options.time_report, "dead code");
+                options.eliminate_dead_code->nodes += ast::countNodes(program);
+                DeadCodeEliminator eliminator(arena, *options.eliminate_dead_code);
+                program->accept(eliminator);
+            }
+        } catch (const output::CompilationError &) {
+            // Reported to `diagnostics`, which is printed below
+        }
+        output::setDiagnostics(previous);
+
+        if (options.mem_report) {
+            options.mem_report->addProgram();
+            options.mem_report->addArena(arena);
+            visitor.reportMemory(*options.mem_report);
+        }
+
+        compiled = diagnostics.empty();
+        if (compiled && options.emit_c && !options.check_only) {
+            TimeScope translate(options.time_report, "emit c");
+            CEmitter emitter(out);
+            program->accept(emitter);
+        } else if (compiled && options.frame_layout && !options.check_only) {
+            FrameLayout layout;
+            {
+                TimeScope frames(options.time_report, "frame layout");
+                program->accept(layout);
+            }
+            layout.print(out);
+        } else if (compiled && options.dump_ir && !options.check_only) {
+            IrBuilder builder;
+            {
+                TimeScope lower(options.time_report, "ir");
+                program->accept(builder);
+            }
+            {
+                TimeScope ssa(options.time_report, "ssa");
+                for (std::unique_ptr<ir::Function> &function : builder.functions) {
+                    ir::buildSsa(*function);
+                }
+            }
+            for (std::unique_ptr<ir::Function> &function : builder.functions) {
+                // A function the verifier rejects is a bug of the compiler, reported in place of its listing
+                if (ir::verify(*function, out)) {
+                    function->print(out);
+                }
+            }
+        } else if (compiled && backend && !options.check_only) {
+            BytecodeCompiler compiler;
+            {
+                TimeScope lower(options.time_report, "bytecode");
+                program->accept(compiler);
+            }
+            if (options.dump_bytecode) {
+                compiler.program.disassemble(out);
+            } else if (options.jit) {
+                std::unique_ptr<vm::Jit> native;
+                {
+                    TimeScope jit(options.time_report, "jit");
+                    native.reset(new vm::Jit(compiler.program));
+                }
+                TimeScope run(options.time_report, "run");
+                native->run(out);
+            } else {
+                TimeScope run(options.time_report, "run");
+                vm::VirtualMachine(compiler.program).run(out);
+            }
+        }
+
+        TimeScope emit(options.time_report, "emit");
+        if (!compiled) {
+            out << diagnostics;
+        } else if (!options.check_only && !backend) {
+            out << visitor.scope_printer;
+        }
+    }
+    arena.reset();
+    return compiled;
+}
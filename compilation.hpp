@@ -0,0 +1,63 @@
+#ifndef COMPILATION_HPP
+#define COMPILATION_HPP
+
+#include <cstddef>
+#include <ostream>
+#include "source_buffer.hpp"
+#include "arena.hpp"
+#include "function_cache.hpp"
+#include "time_report.hpp"
+#include "mem_report.hpp"
+#include "constant_folder.hpp"
+#include "dead_code_eliminator.hpp"
+
+/* Options of a single compilation */
+struct CompileOptions {
+    // Recover from semantic errors and report all of them, instead of stopping at the first one
+    bool all_errors = false;
+    // Only check the program: print its errors and nothing else
+    bool check_only = false;
+    // Threads that check the function bodies. The output does not depend on it
+    size_t jobs = 1;
+    // Serves the bodies that did not change from this cache, and stores the others in it. May be shared by
+    // several compilations
+    FunctionCache *cache = nullptr;
+    // Times the phases of the compilation into this report. May be shared by several compilations
+    TimeReport *time_report = nullptr;
+    // Adds the memory of the compilation to this report, once the analysis is done. May be shared by several
+    // compilations
+    MemoryReport *mem_report = nullptr;
+    // Folds the constants of the program once it is analyzed without errors, and adds what was folded to these
+    // statistics. The bodies are then always analyzed, the cache is not used. May be shared by several compilations
+    FoldStats *fold = nullptr;
+    // Removes the unreachable statements once the program is analyzed without errors (and folded), and adds what
+    // was removed to these statistics. May be shared by several compilations
+    DeadCodeStats *eliminate_dead_code = nullptr;
+    // Once the program is analyzed without errors (and optimized), compile it to bytecode and run it, writing what
+    // it prints to `out` instead of the scopes. The cache is not used
+    bool run = false;
+    // Same, writing the bytecode listing instead of running it
+    bool dump_bytecode = false;
+    // Same, running the bytecode as native code (see Jit)
+    bool jit = false;
+    // Once the program is analyzed without errors (and optimized), write it as a C program (see CEmitter) instead of
+    // the scopes. The cache is not used
+    bool emit_c = false;
+    // Once the program is analyzed without errors (and optimized), write its functions in SSA form (see
+    // ir::buildSsa) instead of the scopes. The cache is not used
+    bool dump_ir = false;
+    // Same, writing the frame layout of every function (see FrameLayout): its slots, its frame size and its stack
+    // depth
+    bool frame_layout = false;
+};
+
+// Compiles one source: parsing, semantic analysis and scope printing. The scopes, or the errors, are written to
+// `out` (only the errors in check-only mode, the output of the program when running it). Returns false if the
+// program has an error. Several compilations may run on different threads
+bool compile(SourceBuffer &source, std::ostream &out, const CompileOptions &options = CompileOptions());
+
+// Same, with the AST built in the given arena. The arena is reset afterwards, keeping its memory for the next
+// compilation
+bool compile(SourceBuffer &source, ast::Arena &arena, std::ostream &out, const CompileOptions &options);
+
+#endif //COMPILATION_HPP
@@ -0,0 +1,149 @@
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <pthread.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "compile_server.hpp"
+#include "compilation.hpp"
+#include "server_protocol.hpp"
+#include "thread_pool.hpp"
+
+/* Helper functions */
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void requestStop(int) {
+    stop_requested = 1;
+}
+
+/* CompileServer class */
+
+CompileServer::CompileServer(std::string path, size_t jobs, FunctionCache &cache)
+        : path(std::move(path)), jobs(jobs), cache(cache) {}
+
+bool CompileServer::run() {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "hw3: socket path too long: " << path << std::endl;
+        return false;
+    }
+    strcpy(address.sun_path, path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "hw3: cannot create a socket" << std::endl;
+        return false;
+    }
+    // A socket left behind by a server that did not stop cleanly
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 128) < 0) {
+        std::cerr << "hw3: cannot listen on " << path << std::endl;
+        close(listener);
+        return false;
+    }
+
+    // Without SA_RESTART, so a signal interrupts the wait for a connection
+    struct sigaction action = {};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // The signals stay blocked but while ppoll() waits, so none is lost between the check of stop_requested and the
+    // wait. They are blocked before the pool starts, so the worker threads inherit the mask and never take them
+    sigset_t stop_signals, wait_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &wait_mask);
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+    // accept() only runs once ppoll() saw a connection pending, and must not block if the client gave up since
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+    {
+        ThreadPool pool(jobs);
+        while (!stop_requested) {
+            pollfd pending = {listener, POLLIN, 0};
+            if (ppoll(&pending, 1, nullptr, &wait_mask) <= 0) {
+                continue;
+            }
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(connections_mutex);
+                connections.insert(connection);
+            }
+            pool.submit([this, connection] {
+                // A task of the pool must not throw: an error ends this connection only
+                try {
+                    serve(connection);
+                } catch (const std::exception &error) {
+                    std::cerr << "hw3: dropping a connection: " << error.what() << std::endl;
+                }
+                std::lock_guard<std::mutex> lock(connections_mutex);
+                connections.erase(connection);
+                close(connection);
+            });
+        }
+        close(listener);
+        unlink(path.c_str());
+
+        // A worker waiting for the next request of a connection reads its end instead, and the pool can stop
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (int connection : connections) {
+            shutdown(connection, SHUT_RD);
+        }
+    }
+    return true;
+}
+
+void CompileServer::serve(int connection) {
+    // Kept by the worker thread from one request to the next
+    thread_local SourceBuffer source;
+    thread_local ast::Arena arena;
+    thread_local std::ostringstream out;
+
+    protocol::RequestHeader request;
+    while (protocol::readFully(connection, &request, sizeof(request))) {
+        if (request.magic != protocol::REQUEST_MAGIC) {
+            return;
+        }
+        if (request.size > protocol::MAX_REQUEST_SIZE) {
+            std::string error = "hw3: program larger than " + std::to_string(protocol::MAX_REQUEST_SIZE) + " bytes\n";
+            protocol::ResponseHeader response = {protocol::RESPONSE_MAGIC, protocol::REJECTED, error.size()};
+            if (protocol::writeFully(connection, &response, sizeof(response))) {
+                protocol::writeFully(connection, error.data(), error.size());
+            }
+            return;
+        }
+        if (!protocol::readFully(connection, source.allocate(request.size), request.size)) {
+            return;
+        }
+
+        CompileOptions options;
+        options.all_errors = request.flags & protocol::ALL_ERRORS;
+        options.check_only = request.flags & protocol::CHECK_ONLY;
+        options.cache = &cache;
+        out.str(std::string());
+        bool compiled = compile(source, arena, out, options);
+
+        std::string result = out.str();
+        protocol::ResponseHeader response = {protocol::RESPONSE_MAGIC,
+                                              compiled ? protocol::COMPILED : protocol::HAS_ERRORS, result.size()};
+        if (!protocol::writeFully(connection, &response, sizeof(response)) ||
+            !protocol::writeFully(connection, result.data(), result.size())) {
+            return;
+        }
+    }
+}
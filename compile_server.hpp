@@ -0,0 +1,37 @@
+#ifndef COMPILE_SERVER_HPP
+#define COMPILE_SERVER_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include "function_cache.hpp"
+
+/* CompileServer class
+ * Long-lived compiler that serves programs sent over a Unix domain socket (see server_protocol.hpp), so callers
+ * do not pay for a process start per program. Connections are handled on a pool of threads. The state of the
+ * process stays warm between requests: the interned strings, the arena and source buffer of every worker thread,
+ * and the cache of function results shared by all the requests.
+ */
+class CompileServer {
+public:
+    // Serves on the socket at `path`, with `jobs` worker threads and the given function cache
+    CompileServer(std::string path, size_t jobs, FunctionCache &cache);
+
+    // Accepts connections until SIGINT or SIGTERM, then answers the requests under way, closes every connection and
+    // removes the socket. Returns false if the socket cannot be set up
+    bool run();
+
+private:
+    // Answers every request of the connection, until the client closes it
+    void serve(int connection);
+
+    std::string path;
+    size_t jobs;
+    FunctionCache &cache;
+    // The open connections, shut down for reading on stop so that no worker waits for a client that stays idle
+    std::mutex connections_mutex;
+    std::unordered_set<int> connections;
+};
+
+#endif //COMPILE_SERVER_HPP
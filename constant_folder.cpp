@@ -0,0 +1,373 @@
+#include <cstdint>
+
+#include "constant_folder.hpp"
+#include "output.hpp"
+
+/* Helper functions */
+
+// Returns whether the expression is a literal the folding works on, and its value (1 or 0 for a Bool)
+static bool literalValue(const ast::Exp *exp, int &value) {
+    switch (exp->kind) {
+        case ast::NodeKind::Num:
+            value = ast::cast<const ast::Num>(exp)->value;
+            return true;
+        case ast::NodeKind::NumB:
+            value = ast::cast<const ast::NumB>(exp)->value;
+            return true;
+        case ast::NodeKind::Bool:
+            value = ast::cast<const ast::Bool>(exp)->value;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Wraps the value to a 32-bit int, as the int arithmetic does at run time
+static int wrapInt(int64_t value) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+/* FoldStats struct */
+
+void FoldStats::print(std::ostream &os) const {
+    size_t before = nodes;
+    size_t removed = nodes_removed;
+    os << "constant folding: " << folded << " operations folded, " << propagated << " constants propagated, "
+       << removed << " of " << before << " nodes removed";
+    if (before) {
+        os << " (" << removed * 100 / before << "%)";
+    }
+    os << std::endl;
+}
+
+/* ConstantFolder class */
+
+ConstantFolder::ConstantFolder(ast::Arena &arena, FoldStats &stats) : arena(arena), stats(stats), result(nullptr) {}
+
+void ConstantFolder::fold(ast::Exp *&exp) {
+    exp->accept(*this);
+    exp = result;
+}
+
+void ConstantFolder::replace(ast::Exp *replacement, size_t removed) {
+    result = replacement;
+    stats.nodes_removed += removed;
+}
+
+void ConstantFolder::replaceWithLiteral(const ast::Exp &node, Constant constant, size_t removed) {
+    ast::Exp *literal;
+    switch (constant.type) {
+        case ast::BuiltInType::INT:
+            literal = arena.make<ast::Num>(constant.value);
+            break;
+        case ast::BuiltInType::BYTE:
+            literal = arena.make<ast::NumB>(constant.value);
+            break;
+        default:
+            literal = arena.make<ast::Bool>(constant.value != 0);
+            break;
+    }
+    literal->line = node.line;
+    literal->type = constant.type;
+    literal->typed = true;
+    replace(literal, removed);
+}
+
+void ConstantFolder::assign(const SymbolEntry *variable, ast::BuiltInType type, const ast::Exp *exp) {
+    int value;
+    if (exp && literalValue(exp, value)) {
+        // A byte assigned to an int variable is read back as an int
+        constants[variable] = {type, value};
+    } else {
+        constants.erase(variable);
+    }
+}
+
+void ConstantFolder::forgetAssigned(const ast::Statement *statement) {
+    switch (statement->kind) {
+        case ast::NodeKind::Statements:
+            for (const ast::Statement *inner : ast::cast<const ast::Statements>(statement)->statements) {
+                forgetAssigned(inner);
+            }
+            break;
+        case ast::NodeKind::If: {
+            auto if_node = ast::cast<const ast::If>(statement);
+            forgetAssigned(if_node->then);
+            if (if_node->otherwise) {
+                forgetAssigned(if_node->otherwise);
+            }
+            break;
+        }
+        case ast::NodeKind::While:
+            forgetAssigned(ast::cast<const ast::While>(statement)->body);
+            break;
+        case ast::NodeKind::Assign:
+            constants.erase(ast::cast<const ast::Assign>(statement)->id->variable);
+            break;
+        default:
+            break;
+    }
+}
+
+void ConstantFolder::visit(ast::Num &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::NumB &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::String &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::Bool &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::ID &node) {
+    result = &node;
+    auto it = node.variable ? constants.find(node.variable) : constants.end();
+    if (it != constants.end()) {
+        stats.propagated++;
+        replaceWithLiteral(node, it->second, 0);
+    }
+}
+
+void ConstantFolder::visit(ast::BinOp &node) {
+    fold(node.left);
+    fold(node.right);
+    result = &node;
+
+    int left, right;
+    if (!literalValue(node.left, left) || !literalValue(node.right, right)) {
+        return;
+    }
+    int64_t value = 0;
+    switch (node.op) {
+        case ast::BinOpType::ADD:
+            value = int64_t(left) + right;
+            break;
+        case ast::BinOpType::SUB:
+            value = int64_t(left) - right;
+            break;
+        case ast::BinOpType::MUL:
+            value = int64_t(left) * right;
+            break;
+        case ast::BinOpType::DIV:
+            if (right == 0) {
+                return;
+            }
+            value = int64_t(left) / right;
+            break;
+    }
+
+    bool is_byte = node.left->kind == ast::NodeKind::NumB && node.right->kind == ast::NodeKind::NumB;
+    if (!is_byte) {
+        stats.folded++;
+        replaceWithLiteral(node, {ast::BuiltInType::INT, wrapInt(value)}, 2);
+        return;
+    }
+    if (value > 255) {
+        output::errorByteTooLarge(node.line, static_cast<int>(value));
+        return;
+    }
+    if (value >= 0) {
+        stats.folded++;
+        replaceWithLiteral(node, {ast::BuiltInType::BYTE, static_cast<int>(value)}, 2);
+    }
+}
+
+void ConstantFolder::visit(ast::RelOp &node) {
+    fold(node.left);
+    fold(node.right);
+    result = &node;
+
+    int left, right;
+    if (!literalValue(node.left, left) || !literalValue(node.right, right)) {
+        return;
+    }
+    bool value = false;
+    switch (node.op) {
+        case ast::RelOpType::EQ:
+            value = left == right;
+            break;
+        case ast::RelOpType::NE:
+            value = left != right;
+            break;
+        case ast::RelOpType::LT:
+            value = left < right;
+            break;
+        case ast::RelOpType::GT:
+            value = left > right;
+            break;
+        case ast::RelOpType::LE:
+            value = left <= right;
+            break;
+        case ast::RelOpType::GE:
+            value = left >= right;
+            break;
+    }
+    stats.folded++;
+    replaceWithLiteral(node, {ast::BuiltInType::BOOL, value}, 2);
+}
+
+void ConstantFolder::visit(ast::Not &node) {
+    fold(node.exp);
+    result = &node;
+
+    int value;
+    if (literalValue(node.exp, value)) {
+        stats.folded++;
+        replaceWithLiteral(node, {ast::BuiltInType::BOOL, !value}, 1);
+    }
+}
+
+void ConstantFolder::visit(ast::And &node) {
+    fold(node.left);
+    fold(node.right);
+    result = &node;
+
+    // The right operand is not evaluated after a false left one, so `false and f()` is false. A false right operand
+    // cannot be folded the same way, the left one may call a function
+    int value;
+    if (literalValue(node.left, value) && value) {
+        stats.folded++;
+        replace(node.right, 2);
+    } else if (literalValue(node.left, value)) {
+        stats.folded++;
+        replace(node.left, 1 + ast::countNodes(node.right));
+    } else if (literalValue(node.right, value) && value) {
+        stats.folded++;
+        replace(node.left, 2);
+    }
+}
+
+void ConstantFolder::visit(ast::Or &node) {
+    fold(node.left);
+    fold(node.right);
+    result = &node;
+
+    // Same as And, with the roles of true and false swapped
+    int value;
+    if (literalValue(node.left, value) && value) {
+        stats.folded++;
+        replace(node.left, 1 + ast::countNodes(node.right));
+    } else if (literalValue(node.left, value)) {
+        stats.folded++;
+        replace(node.right, 2);
+    } else if (literalValue(node.right, value) && !value) {
+        stats.folded++;
+        replace(node.left, 2);
+    }
+}
+
+void ConstantFolder::visit(ast::Type &node) {}
+
+void ConstantFolder::visit(ast::Cast &node) {
+    fold(node.exp);
+    result = &node;
+
+    int value;
+    if (!literalValue(node.exp, value)) {
+        return;
+    }
+    ast::BuiltInType target = node.target_type->type;
+    if (target == ast::BuiltInType::BYTE && value > 255) {
+        output::errorByteTooLarge(node.line, value);
+        return;
+    }
+    if (target == ast::BuiltInType::BYTE && value < 0) {
+        return;
+    }
+    stats.folded++;
+    // The cast, its type and its operand make way for one literal
+    replaceWithLiteral(node, {target, value}, 2);
+}
+
+void ConstantFolder::visit(ast::ExpList &node) {
+    for (ast::Exp *&exp : node.exps) {
+        fold(exp);
+    }
+}
+
+void ConstantFolder::visit(ast::Call &node) {
+    node.args->accept(*this);
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::Statements &node) {
+    for (ast::Statement *statement : node.statements) {
+        statement->accept(*this);
+    }
+}
+
+void ConstantFolder::visit(ast::Break &node) {}
+
+void ConstantFolder::visit(ast::Continue &node) {}
+
+void ConstantFolder::visit(ast::Return &node) {
+    if (node.exp) {
+        fold(node.exp);
+    }
+}
+
+void ConstantFolder::visit(ast::If &node) {
+    fold(node.condition);
+
+    Constants before = constants;
+    node.then->accept(*this);
+    Constants after_then = std::move(constants);
+    constants = std::move(before);
+    if (node.otherwise) {
+        node.otherwise->accept(*this);
+    }
+
+    // Keep only the values both paths agree on
+    for (auto it = constants.begin(); it != constants.end();) {
+        auto then_it = after_then.find(it->first);
+        if (then_it == after_then.end() || !(then_it->second == it->second)) {
+            it = constants.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ConstantFolder::visit(ast::While &node) {
+    // The condition and the body also run after the assignments of the body
+    forgetAssigned(node.body);
+    fold(node.condition);
+
+    Constants before = constants;
+    node.body->accept(*this);
+    constants = std::move(before);
+}
+
+void ConstantFolder::visit(ast::VarDecl &node) {
+    if (node.init_exp) {
+        fold(node.init_exp);
+    }
+    assign(node.id->variable, node.type->type, node.init_exp);
+}
+
+void ConstantFolder::visit(ast::Assign &node) {
+    fold(node.exp);
+    assign(node.id->variable, node.id->variable->type, node.exp);
+}
+
+void ConstantFolder::visit(ast::Formal &node) {}
+
+void ConstantFolder::visit(ast::Formals &node) {}
+
+void ConstantFolder::visit(ast::FuncDecl &node) {
+    // Nothing is known about the formals
+    constants.clear();
+    node.body->accept(*this);
+}
+
+void ConstantFolder::visit(ast::Funcs &node) {
+    for (ast::FuncDecl *func : node.funcs) {
+        func->accept(*this);
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef CONSTANT_FOLDER_HPP
+#define CONSTANT_FOLDER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <unordered_map>
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "arena.hpp"
+#include "symbol_table.hpp"
+
+/* What the constant folding did, summed over every program it ran on. May be shared by several compilations */
+struct FoldStats {
+    // Nodes of the programs before the folding
+    std::atomic<size_t> nodes{0};
+    // Operations replaced by their value
+    std::atomic<size_t> folded{0};
+    // Reads of a variable replaced by its known value
+    std::atomic<size_t> propagated{0};
+    // Nodes no longer reachable from the programs, net of the literals that replaced them
+    std::atomic<size_t> nodes_removed{0};
+
+    void print(std::ostream &os) const;
+};
+
+/* ConstantFolder class
+ * Optional pass over an analyzed program, which replaces every BinOp, RelOp, Not, And, Or and Cast over literals with
+ * a single literal, with the types the analyzer gives them: int arithmetic wraps at 32 bits, a byte operation is
+ * a byte only if both operands are, and a folded byte above 255 is reported like a byte literal that is too large.
+ * Divisions by zero and negative bytes are left for the run time.
+ * Constants are also propagated through VarDecl and Assign along straight-line code: reading a variable whose last
+ * assignment was a literal reads that literal. Both branches of an if start from the values known before it, and
+ * only the values they agree on survive it. The variables assigned in a loop are forgotten for the whole loop.
+ * The new literals are allocated in the arena of the program. The program must have been analyzed without errors,
+ * and not through a FunctionCache: the identifiers of a cached body are not bound.
+ */
+class ConstantFolder : public Visitor {
+public:
+    ConstantFolder(ast::Arena &arena, FoldStats &stats);
+
+    void visit(ast::Num &node) override;
+
+    void visit(ast::NumB &node) override;
+
+    void visit(ast::String &node) override;
+
+    void visit(ast::Bool &node) override;
+
+    void visit(ast::ID &node) override;
+
+    void visit(ast::BinOp &node) override;
+
+    void visit(ast::RelOp &node) override;
+
+    void visit(ast::Not &node) override;
+
+    void visit(ast::And &node) override;
+
+    void visit(ast::Or &node) override;
+
+    void visit(ast::Type &node) override;
+
+    void visit(ast::Cast &node) override;
+
+    void visit(ast::ExpList &node) override;
+
+    void visit(ast::Call &node) override;
+
+    void visit(ast::Statements &node) override;
+
+    void visit(ast::Break &node) override;
+
+    void visit(ast::Continue &node) override;
+
+    void visit(ast::Return &node) override;
+
+    void visit(ast::If &node) override;
+
+    void visit(ast::While &node) override;
+
+    void visit(ast::VarDecl &node) override;
+
+    void visit(ast::Assign &node) override;
+
+    void visit(ast::Formal &node) override;
+
+    void visit(ast::Formals &node) override;
+
+    void visit(ast::FuncDecl &node) override;
+
+    void visit(ast::Funcs &node) override;
+
+private:
+    // Value of a literal, with its type
+    struct Constant {
+        ast::BuiltInType type;
+        int value;
+
+        bool operator==(const Constant &other) const {
+            return type == other.type && value == other.value;
+        }
+    };
+
+    using Constants = std::unordered_map<const SymbolEntry *, Constant>;
+
+    // Folds the expression and replaces it with the result
+    void fold(ast::Exp *&exp);
+
+    // Makes the visited expression fold into `replacement`, which takes the place of `removed` nodes
+    void replace(ast::Exp *replacement, size_t removed);
+
+    // Makes the visited expression fold into a new literal
+    void replaceWithLiteral(const ast::Exp &node, Constant constant, size_t removed);
+
+    // Sets or forgets the value of the variable, after it is assigned the given expression
+    void assign(const SymbolEntry *variable, ast::BuiltInType type, const ast::Exp *exp);
+
+    // Forgets the value of every variable assigned in the statement
+    void forgetAssigned(const ast::Statement *statement);
+
+    ast::Arena &arena;
+    FoldStats &stats;
+    // Known values of the variables at the visited statement
+    Constants constants;
+    // What the last visited expression folded into: itself if it was not folded
+    ast::Exp *result;
+};
+
+#endif //CONSTANT_FOLDER_HPP
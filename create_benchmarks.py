@@ -0,0 +1,105 @@
+import os
+import sys
+
+# Define the output directory
+OUTPUT_DIR = "benchmark_inputs"
+
+if not os.path.exists(OUTPUT_DIR):
+    os.makedirs(OUTPUT_DIR)
+
+# ==========================================
+#              PROGRAM SHAPES
+# ==========================================
+
+
+# Many locals in a single function. Every declaration reads the previous one, so each
+# one costs a shadowing check plus a lookup.
+def symbols_flat(n):
+    lines = ["void main() {", "    int v0 = 0;"]
+    for i in range(1, n):
+        lines.append("    int v{} = v{} + 1;".format(i, i - 1))
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+# Same number of locals, spread over blocks nested up to max_depth levels. Every block reads a
+# variable of the function scope, and is closed again once the nesting gets too deep, so
+# scopes are constantly opened and popped.
+def symbols_nested(n, per_block=8, max_depth=16):
+    lines = ["void main() {", "    int root = 0;"]
+    depth = 0
+    for i in range(n):
+        if i % per_block == 0:
+            if depth == max_depth:
+                while depth > 0:
+                    lines.append("    " * depth + "}")
+                    depth -= 1
+            lines.append("    " * (depth + 1) + "{")
+            depth += 1
+        lines.append("    " * (depth + 1) + "int v{} = root;".format(i))
+    while depth > 0:
+        lines.append("    " * depth + "}")
+        depth -= 1
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+# One very long arithmetic chain, a + b * 2 - ... with n operands. The chain is a left-deep
+# tree of n - 1 binary operations, so every operation sits on top of all the previous ones.
+def long_expressions(n):
+    operators = ["+", "*", "-", "+"]
+    terms = ["x"]
+    for i in range(1, n):
+        terms.append(operators[i % len(operators)])
+        terms.append("x" if i % 3 else "{}".format(i % 100))
+    lines = ["void main() {", "    int x = 1;", "    int y = " + " ".join(terms) + ";", "}"]
+    return "\n".join(lines) + "\n"
+
+
+# n small functions, each calling the previous one. The bodies only depend on the signatures, so they can be
+# checked independently of each other.
+def many_functions(n):
+    lines = ["int f0(int a) {", "    return a;", "}"]
+    for i in range(1, n):
+        lines += [
+            "int f{}(int a) {{".format(i),
+            "    int s = 0;",
+            "    int k = 0;",
+            "    while (k < a) {",
+            "        byte b = 1b;",
+            "        if (k == 3) {",
+            "            s = s + f{}(k) * b;".format(i - 1),
+            "        } else {",
+            "            s = s - k;",
+            "        }",
+            "        k = k + 1;",
+            "    }",
+            "    return s;",
+            "}",
+        ]
+    lines += ["void main() {", "    printi(f{}(5));".format(n - 1), "}"]
+    return "\n".join(lines) + "\n"
+
+
+SHAPES = {
+    "symbols_flat": symbols_flat,
+    "symbols_nested": symbols_nested,
+    "long_expressions": long_expressions,
+    "many_functions": many_functions,
+}
+
+# ==========================================
+#              GENERATION
+# ==========================================
+
+# Usage: python3 create_benchmarks.py <shape> <size> [<size> ...]
+if len(sys.argv) < 3 or sys.argv[1] not in SHAPES:
+    print("Usage: {} <{}> <size> [<size> ...]".format(sys.argv[0], "|".join(SHAPES)))
+    sys.exit(1)
+
+shape = sys.argv[1]
+for size in sys.argv[2:]:
+    path = os.path.join(OUTPUT_DIR, "{}_{}.in".format(shape, size))
+    with open(path, "w") as f:
+        f.write(SHAPES[shape](int(size)))
+    print(path)
@@ -377,6 +377,27 @@ int main() {
     "out": "Program has no 'void main()' function"
 }
 
+# 28. Int Literal Too Large For An Int
+tests["test_fail_int_literal_range"] = {
+    "code": """
+void main() {
+    int a = 2147483647;
+    int b = 99999999999;
+}
+""",
+    "out": "line 3: lexical error"
+}
+
+# 29. Byte Literal Too Large For An Int
+tests["test_fail_byte_literal_range"] = {
+    "code": """
+void main() {
+    byte b = 99999999999b;
+}
+""",
+    "out": "line 2: lexical error"
+}
+
 # ==========================================
 #              GENERATION LOOP
 # ==========================================
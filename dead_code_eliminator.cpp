@@ -0,0 +1,207 @@
+#include <vector>
+
+#include "dead_code_eliminator.hpp"
+
+/* Helper functions */
+
+// Returns whether the expression is a Bool literal, and its value
+static bool boolValue(ast::Exp *exp, bool &value) {
+    ast::Bool *literal = ast::dyn_cast<ast::Bool>(exp);
+    if (literal) {
+        value = literal->value;
+    }
+    return literal != nullptr;
+}
+
+// Returns whether the statement has a break that leaves the loop around it. Breaks in inner loops leave those
+static bool breaksOut(ast::Statement *statement) {
+    switch (statement->kind) {
+        case ast::NodeKind::Break:
+            return true;
+        case ast::NodeKind::Statements:
+            for (ast::Statement *inner : ast::cast<ast::Statements>(statement)->statements) {
+                if (breaksOut(inner)) {
+                    return true;
+                }
+            }
+            return false;
+        case ast::NodeKind::If: {
+            auto if_node = ast::cast<ast::If>(statement);
+            return breaksOut(if_node->then) || (if_node->otherwise && breaksOut(if_node->otherwise));
+        }
+        default:
+            return false;
+    }
+}
+
+/* DeadCodeStats struct */
+
+void DeadCodeStats::print(std::ostream &os) const {
+    size_t before = nodes;
+    size_t removed = nodes_removed;
+    os << "dead code: " << unreachable << " unreachable statements, " << branches << " constant branches, " << loops
+       << " false loops, " << removed << " of " << before << " nodes removed";
+    if (before) {
+        os << " (" << removed * 100 / before << "%)";
+    }
+    os << std::endl;
+}
+
+/* DeadCodeEliminator class */
+
+DeadCodeEliminator::DeadCodeEliminator(ast::Arena &arena, DeadCodeStats &stats)
+        : arena(arena), stats(stats), result(nullptr), ends(false) {}
+
+bool DeadCodeEliminator::prune(ast::Statement *&statement) {
+    int line = statement->line;
+    statement->accept(*this);
+    if (result) {
+        statement = result;
+        return ends;
+    }
+    // An empty block takes the place of one of the removed nodes
+    statement = arena.make<ast::Statements>();
+    statement->line = line;
+    stats.nodes_removed--;
+    return false;
+}
+
+void DeadCodeEliminator::replace(ast::Statement *replacement, size_t removed, bool ends) {
+    result = replacement;
+    this->ends = ends;
+    stats.nodes_removed += removed;
+}
+
+ast::Statements *DeadCodeEliminator::asBlock(ast::Statement *statement) {
+    ast::Statements *block = ast::dyn_cast<ast::Statements>(statement);
+    if (!block) {
+        block = arena.make<ast::Statements>(statement);
+        block->line = statement->line;
+    }
+    return block;
+}
+
+void DeadCodeEliminator::visit(ast::Num &node) {}
+
+void DeadCodeEliminator::visit(ast::NumB &node) {}
+
+void DeadCodeEliminator::visit(ast::String &node) {}
+
+void DeadCodeEliminator::visit(ast::Bool &node) {}
+
+void DeadCodeEliminator::visit(ast::ID &node) {}
+
+void DeadCodeEliminator::visit(ast::BinOp &node) {}
+
+void DeadCodeEliminator::visit(ast::RelOp &node) {}
+
+void DeadCodeEliminator::visit(ast::Not &node) {}
+
+void DeadCodeEliminator::visit(ast::And &node) {}
+
+void DeadCodeEliminator::visit(ast::Or &node) {}
+
+void DeadCodeEliminator::visit(ast::Type &node) {}
+
+void DeadCodeEliminator::visit(ast::Cast &node) {}
+
+void DeadCodeEliminator::visit(ast::ExpList &node) {}
+
+void DeadCodeEliminator::visit(ast::Call &node) {
+    replace(&node, 0);
+}
+
+void DeadCodeEliminator::visit(ast::Statements &node) {
+    std::vector<ast::Statement *> live;
+    bool block_ends = false;
+    for (ast::Statement *statement : node.statements) {
+        if (block_ends) {
+            stats.unreachable++;
+            stats.nodes_removed += ast::countNodes(statement);
+            continue;
+        }
+        statement->accept(*this);
+        if (result) {
+            live.push_back(result);
+        }
+        block_ends = ends;
+    }
+    node.statements = std::move(live);
+    replace(&node, 0, block_ends);
+}
+
+void DeadCodeEliminator::visit(ast::Break &node) {
+    replace(&node, 0, true);
+}
+
+void DeadCodeEliminator::visit(ast::Continue &node) {
+    replace(&node, 0, true);
+}
+
+void DeadCodeEliminator::visit(ast::Return &node) {
+    replace(&node, 0, true);
+}
+
+void DeadCodeEliminator::visit(ast::If &node) {
+    bool value;
+    if (!boolValue(node.condition, value)) {
+        bool then_ends = prune(node.then);
+        bool otherwise_ends = node.otherwise && prune(node.otherwise);
+        replace(&node, 0, then_ends && otherwise_ends);
+        return;
+    }
+
+    // The If and its condition go, along with the branch that does not run
+    stats.branches++;
+    ast::Statement *taken = value ? node.then : node.otherwise;
+    ast::Statement *skipped = value ? node.otherwise : node.then;
+    size_t removed = 1 + ast::countNodes(node.condition) + (skipped ? ast::countNodes(skipped) : 0);
+    if (!taken) {
+        replace(nullptr, removed);
+        return;
+    }
+    taken->accept(*this);
+    if (!result) {
+        replace(nullptr, removed);
+        return;
+    }
+    bool taken_ends = ends;
+    ast::Statements *block = asBlock(result);
+    // A new block takes the place of one of the removed nodes
+    replace(block, block == result ? removed : removed - 1, taken_ends);
+}
+
+void DeadCodeEliminator::visit(ast::While &node) {
+    bool value;
+    bool constant = boolValue(node.condition, value);
+    if (constant && !value) {
+        stats.loops++;
+        replace(nullptr, ast::countNodes(&node));
+        return;
+    }
+    prune(node.body);
+    // Only a break leaves a while (true)
+    replace(&node, 0, constant && !breaksOut(node.body));
+}
+
+void DeadCodeEliminator::visit(ast::VarDecl &node) {
+    replace(&node, 0);
+}
+
+void DeadCodeEliminator::visit(ast::Assign &node) {
+    replace(&node, 0);
+}
+
+void DeadCodeEliminator::visit(ast::Formal &node) {}
+
+void DeadCodeEliminator::visit(ast::Formals &node) {}
+
+void DeadCodeEliminator::visit(ast::FuncDecl &node) {
+    node.body->accept(*this);
+}
+
+void DeadCodeEliminator::visit(ast::Funcs &node) {
+    for (ast::FuncDecl *func : node.funcs) {
+        func->accept(*this);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef DEAD_CODE_ELIMINATOR_HPP
+#define DEAD_CODE_ELIMINATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "arena.hpp"
+
+/* What the dead code elimination removed, summed over every program it ran on. May be shared by several
+ * compilations
+ */
+struct DeadCodeStats {
+    // Nodes of the programs before the elimination
+    std::atomic<size_t> nodes{0};
+    // Statements after a return, break or continue, or after a branch that always ends with one
+    std::atomic<size_t> unreachable{0};
+    // Ifs with a constant condition, replaced by the branch that runs
+    std::atomic<size_t> branches{0};
+    // while (false) loops
+    std::atomic<size_t> loops{0};
+    // Nodes no longer reachable from the programs, net of the blocks that replaced them
+    std::atomic<size_t> nodes_removed{0};
+
+    void print(std::ostream &os) const;
+};
+
+/* DeadCodeEliminator class
+ * Optional pass over an analyzed program, which removes the statements that can never run: whatever follows a
+ * Return, Break or Continue in a Statements list (or an if whose branches all end with one, or a while (true) with
+ * no break), the branch of an if (true) / if (false) that is not taken, and while (false) loops.
+ * An if with a constant condition becomes the branch that runs, as a block so that its declarations keep their
+ * scope. The analysis already ran, so the scopes and offsets it printed do not change.
+ * Best after the ConstantFolder, which turns constant conditions into literals.
+ */
+class DeadCodeEliminator : public Visitor {
+public:
+    DeadCodeEliminator(ast::Arena &arena, DeadCodeStats &stats);
+
+    void visit(ast::Num &node) override;
+
+    void visit(ast::NumB &node) override;
+
+    void visit(ast::String &node) override;
+
+    void visit(ast::Bool &node) override;
+
+    void visit(ast::ID &node) override;
+
+    void visit(ast::BinOp &node) override;
+
+    void visit(ast::RelOp &node) override;
+
+    void visit(ast::Not &node) override;
+
+    void visit(ast::And &node) override;
+
+    void visit(ast::Or &node) override;
+
+    void visit(ast::Type &node) override;
+
+    void visit(ast::Cast &node) override;
+
+    void visit(ast::ExpList &node) override;
+
+    void visit(ast::Call &node) override;
+
+    void visit(ast::Statements &node) override;
+
+    void visit(ast::Break &node) override;
+
+    void visit(ast::Continue &node) override;
+
+    void visit(ast::Return &node) override;
+
+    void visit(ast::If &node) override;
+
+    void visit(ast::While &node) override;
+
+    void visit(ast::VarDecl &node) override;
+
+    void visit(ast::Assign &node) override;
+
+    void visit(ast::Formal &node) override;
+
+    void visit(ast::Formals &node) override;
+
+    void visit(ast::FuncDecl &node) override;
+
+    void visit(ast::Funcs &node) override;
+
+private:
+    // Prunes the statement and replaces it with the result, an empty block if nothing is left of it. Returns
+    // whether the statement never completes normally
+    bool prune(ast::Statement *&statement);
+
+    // Makes the visited statement prune into `replacement` (nullptr if nothing is left of it), with the given nodes
+    // removed
+    void replace(ast::Statement *replacement, size_t removed, bool ends = false);
+
+    // Returns the statement as a block, wrapping it into a new one if it is not
+    ast::Statements *asBlock(ast::Statement *statement);
+
+    ast::Arena &arena;
+    DeadCodeStats &stats;
+    // What the last visited statement pruned into, and whether it never completes normally
+    ast::Statement *result;
+    bool ends;
+};
+
+#endif //DEAD_CODE_ELIMINATOR_HPP
@@ -0,0 +1,99 @@
+#include "diagnostics.hpp"
+
+namespace output {
+
+    std::ostream &operator<<(std::ostream &os, const Diagnostic &diagnostic) {
+        switch (diagnostic.kind) {
+            case DiagnosticKind::Lex:
+                return os << "line " << diagnostic.line << ": lexical error\n";
+            case DiagnosticKind::Syn:
+                return os << "line " << diagnostic.line << ": syntax error\n";
+            case DiagnosticKind::Undef:
+                return os << "line " << diagnostic.line << ":" << " variable " << diagnostic.id << " is not defined"
+                          << std::endl;
+            case DiagnosticKind::DefAsFunc:
+                return os << "line " << diagnostic.line << ":" << " symbol " << diagnostic.id << " is a function"
+                          << std::endl;
+            case DiagnosticKind::UndefFunc:
+                return os << "line " << diagnostic.line << ":" << " function " << diagnostic.id << " is not defined"
+                          << std::endl;
+            case DiagnosticKind::DefAsVar:
+                return os << "line " << diagnostic.line << ":" << " symbol " << diagnostic.id << " is a variable"
+                          << std::endl;
+            case DiagnosticKind::Def:
+                return os << "line " << diagnostic.line << ":" << " symbol " << diagnostic.id << " is already defined"
+                          << std::endl;
+            case DiagnosticKind::PrototypeMismatch:
+                os << "line " << diagnostic.line << ": prototype mismatch, function " << diagnostic.id
+                   << " expects parameters (";
+                for (size_t i = 0; i < diagnostic.param_types.size(); ++i) {
+                    os << diagnostic.param_types[i];
+                    if (i != diagnostic.param_types.size() - 1)
+                        os << ",";
+                }
+                return os << ")" << std::endl;
+            case DiagnosticKind::Mismatch:
+                return os << "line " << diagnostic.line << ":" << " type mismatch" << std::endl;
+            case DiagnosticKind::UnexpectedBreak:
+                return os << "line " << diagnostic.line << ":" << " unexpected break statement" << std::endl;
+            case DiagnosticKind::UnexpectedContinue:
+                return os << "line " << diagnostic.line << ":" << " unexpected continue statement" << std::endl;
+            case DiagnosticKind::MainMissing:
+                return os << "Program has no 'void main()' function" << std::endl;
+            case DiagnosticKind::ByteTooLarge:
+                return os << "line " << diagnostic.line << ": byte value " << diagnostic.value << " out of range"
+                          << std::endl;
+        }
+        return os;
+    }
+
+    const char *CompilationError::what() const noexcept {
+        return "compilation error";
+    }
+
+    /* Diagnostics class */
+
+    Diagnostics::Diagnostics(bool all_errors) : all_errors(all_errors) {}
+
+    void Diagnostics::report(Diagnostic diagnostic) {
+        bool fatal = diagnostic.kind == DiagnosticKind::Lex || diagnostic.kind == DiagnosticKind::Syn;
+        diagnostics.push_back(std::move(diagnostic));
+        if (fatal || !all_errors) {
+            throw CompilationError();
+        }
+    }
+
+    bool Diagnostics::allErrors() const {
+        return all_errors;
+    }
+
+    bool Diagnostics::empty() const {
+        return diagnostics.empty();
+    }
+
+    const std::vector<Diagnostic> &Diagnostics::errors() const {
+        return diagnostics;
+    }
+
+    std::ostream &operator<<(std::ostream &os, const Diagnostics &diagnostics) {
+        for (const Diagnostic &diagnostic : diagnostics.diagnostics) {
+            os << diagnostic;
+        }
+        return os;
+    }
+
+    // Engine of each thread, so concurrent compilations collect their own errors. Threads that never set one get a
+    // first-error engine of their own
+    static thread_local Diagnostics default_diagnostics;
+    static thread_local Diagnostics *current_diagnostics = &default_diagnostics;
+
+    Diagnostics *setDiagnostics(Diagnostics *diagnostics) {
+        Diagnostics *previous = current_diagnostics;
+        current_diagnostics = diagnostics;
+        return previous;
+    }
+
+    Diagnostics &diagnostics() {
+        return *current_diagnostics;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include <exception>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace output {
+
+    enum class DiagnosticKind {
+        Lex,
+        Syn,
+        Undef,
+        DefAsFunc,
+        UndefFunc,
+        DefAsVar,
+        Def,
+        PrototypeMismatch,
+        Mismatch,
+        UnexpectedBreak,
+        UnexpectedContinue,
+        MainMissing,
+        ByteTooLarge
+    };
+
+    /* A single compilation error, with everything needed to print it */
+    struct Diagnostic {
+        DiagnosticKind kind;
+        // Line of the error. Not used by MainMissing
+        int line;
+        // Symbol the error is about, for the definition and prototype errors
+        std::string id;
+        // Parameter types the function expects, for PrototypeMismatch
+        std::vector<std::string> param_types;
+        // Value out of range, for ByteTooLarge
+        int value;
+    };
+
+    // Prints the error in the format of the output::error* functions, newline included
+    std::ostream &operator<<(std::ostream &os, const Diagnostic &diagnostic);
+
+    /* Thrown by Diagnostics::report when the compilation cannot go on */
+    class CompilationError : public std::exception {
+    public:
+        const char *what() const noexcept override;
+    };
+
+    /* Diagnostics class
+     * Collects the errors of one compilation. By default the first error ends the compilation, which is the output
+     * format the tests expect. With all_errors set the semantic analysis recovers from its errors and keeps going, and
+     * every error is kept. Lexical and syntax errors always end the compilation, the parser cannot recover from them.
+     */
+    class Diagnostics {
+    public:
+        explicit Diagnostics(bool all_errors = false);
+
+        // Records the error. Throws CompilationError if the compilation has to stop here
+        void report(Diagnostic diagnostic);
+
+        bool allErrors() const;
+
+        bool empty() const;
+
+        const std::vector<Diagnostic> &errors() const;
+
+        // Prints every error, in the order they were reported
+        friend std::ostream &operator<<(std::ostream &os, const Diagnostics &diagnostics);
+
+    private:
+        bool all_errors;
+        std::vector<Diagnostic> diagnostics;
+    };
+
+    // Makes the given engine collect the errors reported by the calling thread, and returns the previous one
+    Diagnostics *setDiagnostics(Diagnostics *diagnostics);
+
+    // Engine of the calling thread. The output::error* functions report to it
+    Diagnostics &diagnostics();
+}
+
+#endif //DIAGNOSTICS_HPP
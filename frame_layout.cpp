@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <utility>
+
+#include "frame_layout.hpp"
+#include "output.hpp"
+
+FrameLayout::FrameLayout()
+        : frame(nullptr), next(0), print_name(StringInterner::global().intern("print")),
+          printi_name(StringInterner::global().intern("printi")) {}
+
+void FrameLayout::scope(ast::Statement *statement) {
+    int32_t start = next;
+    statement->accept(*this);
+    next = start;
+}
+
+void FrameLayout::stackDepths() {
+    std::unordered_map<Symbol, size_t> indices;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        indices[StringInterner::global().intern(frames[i].name)] = i;
+    }
+
+    // The deepest chain from the caller through the callee, once the depth of the callee is known
+    auto call = [&](Frame &caller, const Frame &callee) {
+        if (callee.stack_depth == -1) {
+            caller.stack_depth = -1;
+        } else if (caller.stack_depth != -1) {
+            caller.stack_depth = std::max(caller.stack_depth, caller.params + caller.frame_size + callee.stack_depth);
+        }
+    };
+
+    // Depth first over the call graph. A call back to a function still on the path closes a cycle: every function
+    // on the path may then recurse, and so does every function that calls one of them
+    enum State { NEW, ON_PATH, DONE };
+    std::vector<State> states(frames.size(), NEW);
+    std::vector<std::pair<size_t, size_t>> path;
+    for (size_t root = 0; root < frames.size(); ++root) {
+        if (states[root] != NEW) {
+            continue;
+        }
+        states[root] = ON_PATH;
+        path.emplace_back(root, 0);
+        while (!path.empty()) {
+            Frame &caller = frames[path.back().first];
+            size_t next_callee = path.back().second++;
+            if (next_callee == caller.callees.size()) {
+                states[path.back().first] = DONE;
+                path.pop_back();
+                if (!path.empty()) {
+                    call(frames[path.back().first], caller);
+                }
+                continue;
+            }
+            size_t callee = indices.at(caller.callees[next_callee]);
+            if (states[callee] == NEW) {
+                states[callee] = ON_PATH;
+                path.emplace_back(callee, 0);
+                continue;
+            }
+            if (states[callee] == ON_PATH) {
+                frames[callee].stack_depth = -1;
+            }
+            call(caller, frames[callee]);
+        }
+    }
+}
+
+void FrameLayout::print(std::ostream &os) const {
+    for (const Frame &function : frames) {
+        os << function.name << ": params " << function.params << ", declared " << function.declared << ", frame "
+           << function.frame_size << ", stack ";
+        if (function.stack_depth == -1) {
+            os << "unbounded (recursive)";
+        } else {
+            os << function.stack_depth;
+        }
+        os << std::endl;
+        for (const Variable &variable : function.variables) {
+            os << "  " << variable.name << ": " << output::toString(variable.type) << ", "
+               << (variable.is_param ? "param " : "slot ") << variable.slot << std::endl;
+        }
+        if (!function.callees.empty()) {
+            os << "  calls";
+            for (Symbol callee : function.callees) {
+                os << " " << StringInterner::global().str(callee);
+            }
+            os << std::endl;
+        }
+    }
+}
+
+void FrameLayout::visit(ast::Num &node) {}
+
+void FrameLayout::visit(ast::NumB &node) {}
+
+void FrameLayout::visit(ast::String &node) {}
+
+void FrameLayout::visit(ast::Bool &node) {}
+
+void FrameLayout::visit(ast::ID &node) {}
+
+void FrameLayout::visit(ast::BinOp &node) {
+    node.left->accept(*this);
+    node.right->accept(*this);
+}
+
+void FrameLayout::visit(ast::RelOp &node) {
+    node.left->accept(*this);
+    node.right->accept(*this);
+}
+
+void FrameLayout::visit(ast::Not &node) {
+    node.exp->accept(*this);
+}
+
+void FrameLayout::visit(ast::And &node) {
+    node.left->accept(*this);
+    node.right->accept(*this);
+}
+
+void FrameLayout::visit(ast::Or &node) {
+    node.left->accept(*this);
+    node.right->accept(*this);
+}
+
+void FrameLayout::visit(ast::Type &node) {}
+
+void FrameLayout::visit(ast::Cast &node) {
+    node.exp->accept(*this);
+}
+
+void FrameLayout::visit(ast::ExpList &node) {
+    for (ast::Exp *exp : node.exps) {
+        exp->accept(*this);
+    }
+}
+
+void FrameLayout::visit(ast::Call &node) {
+    node.args->accept(*this);
+    Symbol name = node.func_id->name;
+    // The built-in functions take no frame
+    if (name == print_name || name == printi_name) {
+        return;
+    }
+    if (std::find(frame->callees.begin(), frame->callees.end(), name) == frame->callees.end()) {
+        frame->callees.push_back(name);
+    }
+}
+
+void FrameLayout::visit(ast::Statements &node) {
+    int32_t start = next;
+    for (ast::Statement *statement : node.statements) {
+        statement->accept(*this);
+    }
+    next = start;
+}
+
+void FrameLayout::visit(ast::Break &node) {}
+
+void FrameLayout::visit(ast::Continue &node) {}
+
+void FrameLayout::visit(ast::Return &node) {
+    if (node.exp) {
+        node.exp->accept(*this);
+    }
+}
+
+void FrameLayout::visit(ast::If &node) {
+    node.condition->accept(*this);
+    scope(node.then);
+    if (node.otherwise) {
+        scope(node.otherwise);
+    }
+}
+
+void FrameLayout::visit(ast::While &node) {
+    node.condition->accept(*this);
+    scope(node.body);
+}
+
+void FrameLayout::visit(ast::VarDecl &node) {
+    if (node.init_exp) {
+        node.init_exp->accept(*this);
+    }
+    slots[node.id->variable] = next;
+    frame->variables.push_back({node.id->text(), node.type->type, next, false});
+    frame->declared++;
+    frame->frame_size = std::max(frame->frame_size, ++next);
+}
+
+void FrameLayout::visit(ast::Assign &node) {
+    node.exp->accept(*this);
+}
+
+void FrameLayout::visit(ast::Formal &node) {}
+
+void FrameLayout::visit(ast::Formals &node) {}
+
+void FrameLayout::visit(ast::FuncDecl &node) {
+    std::vector<ast::Formal *> &formals = node.formals->formals;
+    frames.push_back({node.id->text(), static_cast<int32_t>(formals.size()), 0, 0, {}, 0, {}});
+    frame = &frames.back();
+    next = 0;
+    for (size_t i = 0; i < formals.size(); ++i) {
+        frame->variables.push_back({formals[i]->id->text(), formals[i]->type->type, static_cast<int32_t>(i), true});
+    }
+    node.body->accept(*this);
+    frame = nullptr;
+}
+
+void FrameLayout::visit(ast::Funcs &node) {
+    frames.reserve(node.funcs.size());
+    for (ast::FuncDecl *func : node.funcs) {
+        func->accept(*this);
+    }
+    // The own frame of every function, before the deepest chain of its callees is added
+    for (Frame &function : frames) {
+        function.stack_depth = function.params + function.frame_size;
+    }
+    stackDepths();
+}
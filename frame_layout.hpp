@@ -0,0 +1,128 @@
+#ifndef FRAME_LAYOUT_HPP
+#define FRAME_LAYOUT_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "symbol_table.hpp"
+
+/* FrameLayout class
+ * Assigns the locals of an analyzed program to frame slots by the lifetime of their scopes. The offsets of the
+ * analyzer only grow within a function (besides restarting in while scopes), so the frame takes a slot for every
+ * declaration. Here the slots of a scope are free again once it ends, so sibling scopes (the branches of an if, two
+ * loops one after the other, two blocks) share them, and a frame is as large as the most locals alive at once.
+ * The call graph then gives the deepest stack a call of every function can take, unless it may recurse.
+ * Like the BytecodeCompiler, it needs a program analyzed without errors and not through a FunctionCache.
+ */
+class FrameLayout : public Visitor {
+public:
+    // A variable of a function, in the order of its declaration
+    struct Variable {
+        std::string name;
+        ast::BuiltInType type;
+        // Index of the argument for a parameter, slot after the arguments for a local
+        int32_t slot;
+        bool is_param;
+    };
+
+    // The frame of a function
+    struct Frame {
+        std::string name;
+        int32_t params;
+        // Slots of the locals if none were shared: one for every declaration
+        int32_t declared;
+        // Slots of the locals, with the sibling scopes sharing theirs
+        int32_t frame_size;
+        // The user functions it calls, each once
+        std::vector<Symbol> callees;
+        // Slots of the frames (arguments included) on its deepest call chain, or -1 if it may recurse
+        int64_t stack_depth;
+        std::vector<Variable> variables;
+    };
+
+    FrameLayout();
+
+    void visit(ast::Num &node) override;
+
+    void visit(ast::NumB &node) override;
+
+    void visit(ast::String &node) override;
+
+    void visit(ast::Bool &node) override;
+
+    void visit(ast::ID &node) override;
+
+    void visit(ast::BinOp &node) override;
+
+    void visit(ast::RelOp &node) override;
+
+    void visit(ast::Not &node) override;
+
+    void visit(ast::And &node) override;
+
+    void visit(ast::Or &node) override;
+
+    void visit(ast::Type &node) override;
+
+    void visit(ast::Cast &node) override;
+
+    void visit(ast::ExpList &node) override;
+
+    void visit(ast::Call &node) override;
+
+    void visit(ast::Statements &node) override;
+
+    void visit(ast::Break &node) override;
+
+    void visit(ast::Continue &node) override;
+
+    void visit(ast::Return &node) override;
+
+    void visit(ast::If &node) override;
+
+    void visit(ast::While &node) override;
+
+    void visit(ast::VarDecl &node) override;
+
+    void visit(ast::Assign &node) override;
+
+    void visit(ast::Formal &node) override;
+
+    void visit(ast::Formals &node) override;
+
+    void visit(ast::FuncDecl &node) override;
+
+    void visit(ast::Funcs &node) override;
+
+    // Slot of the local among those of its function, counted after the arguments
+    int32_t slot(const SymbolEntry *variable) const {
+        return slots.at(variable);
+    }
+
+    // Writes the frame of every function, its variables and its stack depth
+    void print(std::ostream &os) const;
+
+    // The frames of the functions, in the order of the program, once a Funcs node is visited
+    std::vector<Frame> frames;
+
+private:
+    // Lays out the statement in a scope of its own
+    void scope(ast::Statement *statement);
+
+    // Works out the stack depth of every frame from the call graph
+    void stackDepths();
+
+    std::unordered_map<const SymbolEntry *, int32_t> slots;
+    // The frame being laid out, and its first free slot
+    Frame *frame;
+    int32_t next;
+    Symbol print_name;
+    Symbol printi_name;
+};
+
+#endif //FRAME_LAYOUT_HPP
@@ -0,0 +1,421 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "function_cache.hpp"
+#include "visitor.hpp"
+
+/* Helper functions */
+
+// Version of the entry format and of the analysis. Bump it whenever either changes, so old entries stop matching
+static const char CACHE_VERSION[] = "hw3-function-cache-1";
+static const uint32_t ENTRY_MAGIC = 0x43334857;
+
+static uint64_t elapsedSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 64-bit FNV-1a, continued from the given hash (or started from an offset basis)
+static uint64_t hash64(const std::string &bytes, uint64_t basis) {
+    uint64_t hash = basis;
+    for (unsigned char byte : bytes) {
+        hash ^= byte;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+static void put(std::string &out, T value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void putString(std::string &out, const std::string &str) {
+    put<uint32_t>(out, str.size());
+    out += str;
+}
+
+/* Reads back what put / putString wrote. Every read fails once the data runs out */
+class Reader {
+public:
+    Reader(const char *data, size_t size) : data(data), end(data + size) {}
+
+    template <typename T>
+    bool get(T &value) {
+        if (static_cast<size_t>(end - data) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+        return true;
+    }
+
+    bool getString(std::string &str) {
+        uint32_t size;
+        if (!get(size) || static_cast<size_t>(end - data) < size) {
+            return false;
+        }
+        str.assign(data, size);
+        data += size;
+        return true;
+    }
+
+    bool done() const {
+        return data == end;
+    }
+
+private:
+    const char *data;
+    const char *end;
+};
+
+/* Serializes a function: the kind, relative line and contents of every node. Two functions get the same bytes
+ * iff they have the same tokens, with the same line breaks between them
+ */
+class FingerprintVisitor : public Visitor {
+public:
+    explicit FingerprintVisitor(int base_line) : base_line(base_line) {}
+
+    std::string bytes;
+
+    void visit(ast::Num &node) override {
+        node_(node);
+        put(bytes, node.value);
+    }
+
+    void visit(ast::NumB &node) override {
+        node_(node);
+        put(bytes, node.value);
+    }
+
+    void visit(ast::String &node) override {
+        node_(node);
+        putString(bytes, std::string(node.value));
+    }
+
+    void visit(ast::Bool &node) override {
+        node_(node);
+        put(bytes, node.value);
+    }
+
+    void visit(ast::ID &node) override {
+        node_(node);
+        putString(bytes, node.text());
+    }
+
+    void visit(ast::BinOp &node) override {
+        node_(node);
+        put<int32_t>(bytes, node.op);
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void visit(ast::RelOp &node) override {
+        node_(node);
+        put<int32_t>(bytes, node.op);
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void visit(ast::Not &node) override {
+        node_(node);
+        node.exp->accept(*this);
+    }
+
+    void visit(ast::And &node) override {
+        node_(node);
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void visit(ast::Or &node) override {
+        node_(node);
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void visit(ast::Type &node) override {
+        node_(node);
+        put<int32_t>(bytes, node.type);
+    }
+
+    void visit(ast::Cast &node) override {
+        node_(node);
+        node.exp->accept(*this);
+        node.target_type->accept(*this);
+    }
+
+    void visit(ast::ExpList &node) override {
+        node_(node);
+        put<uint32_t>(bytes, node.exps.size());
+        for (ast::Exp *exp : node.exps) {
+            exp->accept(*this);
+        }
+    }
+
+    void visit(ast::Call &node) override {
+        node_(node);
+        node.func_id->accept(*this);
+        node.args->accept(*this);
+    }
+
+    void visit(ast::Statements &node) override {
+        node_(node);
+        put<uint32_t>(bytes, node.statements.size());
+        for (ast::Statement *statement : node.statements) {
+            statement->accept(*this);
+        }
+    }
+
+    void visit(ast::Break &node) override {
+        node_(node);
+    }
+
+    void visit(ast::Continue &node) override {
+        node_(node);
+    }
+
+    void visit(ast::Return &node) override {
+        node_(node);
+        optional(node.exp);
+    }
+
+    void visit(ast::If &node) override {
+        node_(node);
+        node.condition->accept(*this);
+        node.then->accept(*this);
+        optional(node.otherwise);
+    }
+
+    void visit(ast::While &node) override {
+        node_(node);
+        node.condition->accept(*this);
+        node.body->accept(*this);
+    }
+
+    void visit(ast::VarDecl &node) override {
+        node_(node);
+        node.id->accept(*this);
+        node.type->accept(*this);
+        optional(node.init_exp);
+    }
+
+    void visit(ast::Assign &node) override {
+        node_(node);
+        node.id->accept(*this);
+        node.exp->accept(*this);
+    }
+
+    void visit(ast::Formal &node) override {
+        node_(node);
+        node.id->accept(*this);
+        node.type->accept(*this);
+    }
+
+    void visit(ast::Formals &node) override {
+        node_(node);
+        put<uint32_t>(bytes, node.formals.size());
+        for (ast::Formal *formal : node.formals) {
+            formal->accept(*this);
+        }
+    }
+
+    void visit(ast::FuncDecl &node) override {
+        node_(node);
+        node.id->accept(*this);
+        node.return_type->accept(*this);
+        node.formals->accept(*this);
+        node.body->accept(*this);
+    }
+
+    void visit(ast::Funcs &node) override {
+        node_(node);
+    }
+
+private:
+    int base_line;
+
+    // Header of every node
+    void node_(const ast::Node &node) {
+        put<uint8_t>(bytes, static_cast<uint8_t>(node.kind));
+        put<int32_t>(bytes, node.line - base_line);
+    }
+
+    template <typename T>
+    void optional(T *node) {
+        put<uint8_t>(bytes, node != nullptr);
+        if (node) {
+            node->accept(*this);
+        }
+    }
+};
+
+/* FunctionCache class */
+
+FunctionCache::FunctionCache() : hits(0), misses(0), saved_ns(0), overhead_ns(0) {}
+
+FunctionCache::FunctionCache(std::string directory)
+        : directory(std::move(directory)), hits(0), misses(0), saved_ns(0), overhead_ns(0) {
+    mkdir(this->directory.c_str(), 0777);
+}
+
+FunctionCache::Key FunctionCache::context(const SymbolTable &table, size_t count, bool all_errors,
+                                          bool print_scopes) {
+    std::string bytes = CACHE_VERSION;
+    put<uint8_t>(bytes, all_errors);
+    put<uint8_t>(bytes, print_scopes);
+    put<uint32_t>(bytes, count);
+    for (size_t i = 0; i < count; ++i) {
+        const FunctionSymbolEntry &function = table.function(i);
+        putString(bytes, StringInterner::global().str(function.name));
+        put<int32_t>(bytes, function.return_type);
+        put<uint32_t>(bytes, function.arguments.size());
+        for (ast::BuiltInType argument : function.arguments) {
+            put<int32_t>(bytes, argument);
+        }
+    }
+    return {hash64(bytes, 0xcbf29ce484222325ULL), hash64(bytes, 0x84222325cbf29ce4ULL)};
+}
+
+FunctionCache::Key FunctionCache::key(const ast::FuncDecl &function, const Key &context) {
+    auto start = std::chrono::steady_clock::now();
+
+    FingerprintVisitor fingerprint(function.id->line);
+    const_cast<ast::FuncDecl &>(function).accept(fingerprint);
+    Key key = {hash64(fingerprint.bytes, context.name), hash64(fingerprint.bytes, context.check)};
+
+    overhead_ns += elapsedSince(start);
+    return key;
+}
+
+std::string FunctionCache::pathOf(const Key &key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.fn", static_cast<unsigned long long>(key.name));
+    return directory + name;
+}
+
+bool FunctionCache::load(const Key &key, int base_line, FunctionResult &result) {
+    auto start = std::chrono::steady_clock::now();
+    bool hit = false;
+
+    std::string data;
+    if (readEntry(key, data)) {
+        Reader reader(data.data(), data.size());
+        uint32_t magic, count;
+        uint64_t check, analysis_ns;
+        FunctionResult entry;
+        bool ok = reader.get(magic) && magic == ENTRY_MAGIC && reader.get(check) && check == key.check &&
+                  reader.get(analysis_ns) && reader.getString(entry.scopes) && reader.get(count);
+        for (uint32_t i = 0; ok && i < count; ++i) {
+            output::Diagnostic error = {};
+            uint8_t kind = 0;
+            uint32_t params = 0;
+            ok = reader.get(kind) && reader.get(error.line) && reader.getString(error.id) && reader.get(error.value) &&
+                 reader.get(params);
+            error.kind = static_cast<output::DiagnosticKind>(kind);
+            error.line += base_line;
+            for (uint32_t j = 0; ok && j < params; ++j) {
+                error.param_types.emplace_back();
+                ok = reader.getString(error.param_types.back());
+            }
+            entry.errors.push_back(std::move(error));
+        }
+
+        if (ok && reader.done()) {
+            result = std::move(entry);
+            saved_ns += analysis_ns;
+            hit = true;
+        }
+    }
+
+    ++(hit ? hits : misses);
+    overhead_ns += elapsedSince(start);
+    return hit;
+}
+
+void FunctionCache::store(const Key &key, int base_line, const FunctionResult &result, uint64_t analysis_ns) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::string data;
+    put<uint32_t>(data, ENTRY_MAGIC);
+    put(data, key.check);
+    put(data, analysis_ns);
+    putString(data, result.scopes);
+    put<uint32_t>(data, result.errors.size());
+    for (const output::Diagnostic &error : result.errors) {
+        put<uint8_t>(data, static_cast<uint8_t>(error.kind));
+        put<int32_t>(data, error.line - base_line);
+        putString(data, error.id);
+        put<int32_t>(data, error.value);
+        put<uint32_t>(data, error.param_types.size());
+        for (const std::string &param : error.param_types) {
+            putString(data, param);
+        }
+    }
+
+    writeEntry(key, data);
+
+    overhead_ns += elapsedSince(start);
+}
+
+bool FunctionCache::readEntry(const Key &key, std::string &data) {
+    if (directory.empty()) {
+        std::lock_guard<std::mutex> lock(memory_mutex);
+        auto it = memory.find(key.name);
+        if (it == memory.end()) {
+            return false;
+        }
+        data = it->second;
+        return true;
+    }
+
+    FILE *file = fopen(pathOf(key).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char chunk[64 * 1024];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.append(chunk, read);
+    }
+    fclose(file);
+    return true;
+}
+
+void FunctionCache::writeEntry(const Key &key, const std::string &data) {
+    if (directory.empty()) {
+        std::lock_guard<std::mutex> lock(memory_mutex);
+        if (memory.size() >= MEMORY_ENTRIES) {
+            memory.clear();
+        }
+        memory[key.name] = data;
+        return;
+    }
+
+    // Write a temporary file and rename it over the entry, so readers never see a partial entry
+    std::string temporary = directory + "/.tmp-XXXXXX";
+    int fd = mkstemp(&temporary[0]);
+    if (fd >= 0) {
+        bool written = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+        close(fd);
+        if (!written || rename(temporary.c_str(), pathOf(key).c_str()) != 0) {
+            unlink(temporary.c_str());
+        }
+    }
+}
+
+void FunctionCache::printStats(std::ostream &os) const {
+    uint64_t lookups = hits + misses;
+    double hit_rate = lookups ? 100.0 * hits / lookups : 0.0;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "function cache: %llu hits, %llu misses (%.1f%% hit rate), %.3f ms of analysis saved, %.3f ms spent "
+             "in the cache\n",
+             static_cast<unsigned long long>(hits.load()), static_cast<unsigned long long>(misses.load()), hit_rate,
+             saved_ns / 1e6, overhead_ns / 1e6);
+    os << line;
+}
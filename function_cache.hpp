@@ -0,0 +1,84 @@
+#ifndef FUNCTION_CACHE_HPP
+#define FUNCTION_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "nodes.hpp"
+#include "diagnostics.hpp"
+#include "symbol_table.hpp"
+
+/* Result of the analysis of a single function body: its scope output and its errors */
+struct FunctionResult {
+    std::string scopes;
+    std::vector<output::Diagnostic> errors;
+};
+
+/* FunctionCache class
+ * On-disk cache of the analysis results of function bodies, one file per function, so that recompiling a file
+ * only analyzes the functions that changed.
+ * The key of a function hashes its whole AST (every token, with lines taken relative to the function name), the
+ * global signature table and the analysis options. A body only depends on these, so any change to the function
+ * or to any signature gives a different key. Lines are relative, so functions that only moved still hit; the
+ * lines of their errors are rebased on load.
+ * Entries are written to a temporary file and renamed, so concurrent compilations may share a directory.
+ * Without a directory the entries are kept in memory instead, for a process that compiles many programs.
+ */
+class FunctionCache {
+public:
+    struct Key {
+        // Names the entry file
+        uint64_t name;
+        // Stored in the entry and compared on load, so a collision of `name` alone is not a hit
+        uint64_t check;
+    };
+
+    // Keeps the entries in memory, up to MEMORY_ENTRIES of them
+    FunctionCache();
+
+    // Uses the given directory, creating it if it does not exist
+    explicit FunctionCache(std::string directory);
+
+    // Hashes what every body depends on besides its own AST: the signatures of the first `count` functions of the
+    // table and the analysis options. Computed once per program and passed to key()
+    static Key context(const SymbolTable &table, size_t count, bool all_errors, bool print_scopes);
+
+    // Key of the function, in the given context
+    Key key(const ast::FuncDecl &function, const Key &context);
+
+    // Loads the result of the function whose name is on `base_line`. Returns false on a miss
+    bool load(const Key &key, int base_line, FunctionResult &result);
+
+    // Stores the result of the function whose name is on `base_line`, analyzed in `analysis_ns` nanoseconds
+    void store(const Key &key, int base_line, const FunctionResult &result, uint64_t analysis_ns);
+
+    // Hits, misses, hit rate, and the analysis time the hits saved against the time spent on the cache
+    void printStats(std::ostream &os) const;
+
+private:
+    // Entries kept by an in-memory cache. It is emptied once it holds that many
+    static const size_t MEMORY_ENTRIES = 1 << 16;
+
+    std::string pathOf(const Key &key) const;
+
+    // Raw bytes of an entry, from the directory or from memory
+    bool readEntry(const Key &key, std::string &data);
+    void writeEntry(const Key &key, const std::string &data);
+
+    std::string directory;
+    std::mutex memory_mutex;
+    std::unordered_map<uint64_t, std::string> memory;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    // Analysis time of the entries that were hit, as measured when they were stored
+    std::atomic<uint64_t> saved_ns;
+    // Time spent hashing, loading and storing
+    std::atomic<uint64_t> overhead_ns;
+};
+
+#endif //FUNCTION_CACHE_HPP
@@ -0,0 +1,56 @@
+#include "interner.hpp"
+
+Symbol StringInterner::intern(std::string_view str) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = index.find(str);
+        if (it != index.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Another thread may have interned the string between the two locks
+    auto it = index.find(str);
+    if (it != index.end()) {
+        return it->second;
+    }
+
+    Symbol symbol = static_cast<Symbol>(strings.size());
+    strings.emplace_back(str);
+    index.emplace(strings.back(), symbol);
+    return symbol;
+}
+
+const std::string &StringInterner::str(Symbol symbol) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return strings[symbol];
+}
+
+size_t StringInterner::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return strings.size();
+}
+
+MemoryUsage StringInterner::memoryUsage() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    MemoryUsage usage;
+    usage.objects = strings.size();
+    for (const std::string &str : strings) {
+        // Short strings are stored inside the std::string itself
+        bool on_heap = str.capacity() > std::string().capacity();
+        usage.live_bytes += sizeof(std::string) + (on_heap ? str.size() + 1 : 0);
+        usage.peak_bytes += sizeof(std::string) + (on_heap ? str.capacity() + 1 : 0);
+    }
+    // One node per string (a view, a handle and the next pointer), and the buckets
+    size_t index_bytes = index.size() * (sizeof(std::pair<std::string_view, Symbol>) + sizeof(void *)) +
+                         index.bucket_count() * sizeof(void *);
+    usage.live_bytes += index_bytes;
+    usage.peak_bytes += index_bytes;
+    return usage;
+}
+
+StringInterner &StringInterner::global() {
+    static StringInterner interner;
+    return interner;
+}
@@ -0,0 +1,45 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "mem_report.hpp"
+
+/* Handle of an interned string. Two handles are equal iff the strings they stand for are equal. */
+using Symbol = std::uint32_t;
+
+/* StringInterner class
+ * Keeps a single copy of every distinct identifier and hands out dense 32-bit handles for them,
+ * so names can be stored and compared as integers. The scanner interns every identifier it reads.
+ * It is safe to use from several threads: lookups share a lock and only new strings take it exclusively.
+ */
+class StringInterner {
+public:
+    // Returns the handle of the given string, interning it if it is seen for the first time
+    Symbol intern(std::string_view str);
+
+    // Returns the string the handle stands for
+    const std::string &str(Symbol symbol) const;
+
+    // Number of distinct strings interned so far. Every handle is smaller than this number
+    size_t size() const;
+
+    // The strings and the index. The index nodes are estimated, as the map does not expose them
+    MemoryUsage memoryUsage() const;
+
+    // The interner shared by the whole compiler
+    static StringInterner &global();
+
+private:
+    // Interned strings by handle. A deque never moves its elements, so the keys of `index` stay valid
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, Symbol> index;
+    mutable std::shared_mutex mutex;
+};
+
+#endif //INTERNER_HPP
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <utility>
+
+#include "ir.hpp"
+#include "output.hpp"
+
+namespace ir {
+
+    /* Helper functions */
+
+    const char *opcodeName(Opcode opcode) {
+        switch (opcode) {
+            case Opcode::CONST:
+                return "const";
+            case Opcode::PARAM:
+                return "param";
+            case Opcode::PHI:
+                return "phi";
+            case Opcode::LOAD:
+                return "load";
+            case Opcode::STORE:
+                return "store";
+            case Opcode::ADD:
+                return "add";
+            case Opcode::SUB:
+                return "sub";
+            case Opcode::MUL:
+                return "mul";
+            case Opcode::DIV:
+                return "div";
+            case Opcode::TRUNC:
+                return "trunc";
+            case Opcode::EQ:
+                return "eq";
+            case Opcode::NE:
+                return "ne";
+            case Opcode::LT:
+                return "lt";
+            case Opcode::GT:
+                return "gt";
+            case Opcode::LE:
+                return "le";
+            case Opcode::GE:
+                return "ge";
+            case Opcode::NOT:
+                return "not";
+            case Opcode::CALL:
+                return "call";
+            case Opcode::PRINT:
+                return "print";
+            case Opcode::JUMP:
+                return "jump";
+            case Opcode::BRANCH:
+                return "branch";
+            default:
+                return "ret";
+        }
+    }
+
+    static void printBlockName(std::ostream &os, const Block *block) {
+        os << "b" << block->id;
+    }
+
+    static void printInstruction(std::ostream &os, const Function &function, const Instruction &instruction) {
+        os << "  ";
+        if (instruction.type != ast::BuiltInType::VOID) {
+            os << "%" << instruction.id << ": " << output::toString(instruction.type) << " = ";
+        }
+        os << opcodeName(instruction.opcode);
+        switch (instruction.opcode) {
+            case Opcode::CONST:
+            case Opcode::PARAM:
+                os << " " << instruction.immediate;
+                break;
+            case Opcode::PHI:
+                for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                    os << (i ? ", [" : " [");
+                    if (instruction.operands[i]) {
+                        os << "%" << instruction.operands[i]->id;
+                    } else {
+                        os << "?";
+                    }
+                    os << ", ";
+                    printBlockName(os, instruction.block->preds[i]);
+                    os << "]";
+                }
+                os << "  ; " << function.variables[instruction.immediate].name;
+                break;
+            case Opcode::LOAD:
+                os << " " << function.variables[instruction.immediate].name;
+                break;
+            case Opcode::STORE:
+                os << " " << function.variables[instruction.immediate].name << ", %" << instruction.operands[0]->id;
+                break;
+            case Opcode::CALL:
+                os << " " << StringInterner::global().str(instruction.callee) << "(";
+                for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                    os << (i ? ", %" : "%") << instruction.operands[i]->id;
+                }
+                os << ")";
+                break;
+            case Opcode::PRINT:
+                os << " \"" << instruction.string << "\"";
+                break;
+            case Opcode::JUMP:
+                os << " ";
+                printBlockName(os, instruction.targets[0]);
+                break;
+            case Opcode::BRANCH:
+                os << " %" << instruction.operands[0]->id << ", ";
+                printBlockName(os, instruction.targets[0]);
+                os << ", ";
+                printBlockName(os, instruction.targets[1]);
+                break;
+            default:
+                for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                    os << (i ? ", %" : " %") << instruction.operands[i]->id;
+                }
+        }
+        os << std::endl;
+    }
+
+    /* Function class */
+
+    Function::Function(std::string name, int32_t params, ast::BuiltInType return_type)
+            : name(std::move(name)), params(params), return_type(return_type), next_value(0) {}
+
+    Block *Function::createBlock() {
+        block_storage.emplace_back();
+        Block *block = &block_storage.back();
+        block->id = static_cast<int32_t>(blocks.size());
+        blocks.push_back(block);
+        return block;
+    }
+
+    Instruction *Function::create(Opcode opcode, ast::BuiltInType type, std::vector<Instruction *> operands,
+                                  int32_t immediate) {
+        instruction_storage.push_back({opcode, next_value++, type, std::move(operands), immediate, 0, {},
+                                       {nullptr, nullptr}, nullptr});
+        return &instruction_storage.back();
+    }
+
+    void Function::renumber() {
+        int32_t value = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i]->id = static_cast<int32_t>(i);
+            for (Instruction *instruction : blocks[i]->instructions) {
+                instruction->id = value++;
+            }
+        }
+        next_value = std::max(next_value, value);
+    }
+
+    void Function::print(std::ostream &os) const {
+        os << name << ": params " << params << ", returns " << output::toString(return_type) << std::endl;
+        for (const Block *block : blocks) {
+            printBlockName(os, block);
+            os << ":";
+            for (size_t i = 0; i < block->preds.size(); ++i) {
+                os << (i ? ", " : "  ; preds ");
+                printBlockName(os, block->preds[i]);
+            }
+            os << std::endl;
+            for (const Instruction *instruction : block->instructions) {
+                printInstruction(os, *this, *instruction);
+            }
+        }
+    }
+
+    /* DominatorTree class */
+
+    DominatorTree::DominatorTree(const Function &function)
+            : idoms(function.blocks.size(), nullptr), tree(function.blocks.size()),
+              enter(function.blocks.size(), -1), exit(function.blocks.size(), -1) {
+        const std::vector<Block *> &blocks = function.blocks;
+        if (blocks.empty()) {
+            return;
+        }
+
+        // Depth first numbering of the reachable blocks, and the parent of each one in the search
+        std::vector<int32_t> number(blocks.size(), -1);
+        std::vector<Block *> vertex;
+        std::vector<int32_t> parent;
+        std::vector<std::pair<Block *, size_t>> stack = {{blocks[0], 0}};
+        number[0] = 0;
+        vertex.push_back(blocks[0]);
+        parent.push_back(-1);
+        while (!stack.empty()) {
+            Block *block = stack.back().first;
+            size_t next = stack.back().second++;
+            if (next == block->succs.size()) {
+                stack.pop_back();
+                continue;
+            }
+            Block *succ = block->succs[next];
+            if (number[succ->id] == -1) {
+                number[succ->id] = static_cast<int32_t>(vertex.size());
+                vertex.push_back(succ);
+                parent.push_back(number[block->id]);
+                stack.emplace_back(succ, 0);
+            }
+        }
+
+        // Semidominators, then the immediate dominators, all by depth first number
+        int32_t count = static_cast<int32_t>(vertex.size());
+        std::vector<int32_t> semi(count);
+        std::vector<int32_t> label(count);
+        std::vector<int32_t> ancestor(count, -1);
+        std::vector<int32_t> idom(count, -1);
+        std::vector<std::vector<int32_t>> bucket(count);
+        for (int32_t i = 0; i < count; ++i) {
+            semi[i] = label[i] = i;
+        }
+        std::vector<int32_t> path;
+        // The vertex of least semidominator on the path from v up to the root of its tree in the forest
+        auto eval = [&](int32_t v) {
+            if (ancestor[v] == -1) {
+                return v;
+            }
+            // Compresses the path, from the top down
+            for (int32_t u = v; ancestor[ancestor[u]] != -1; u = ancestor[u]) {
+                path.push_back(u);
+            }
+            while (!path.empty()) {
+                int32_t u = path.back();
+                path.pop_back();
+                if (semi[label[ancestor[u]]] < semi[label[u]]) {
+                    label[u] = label[ancestor[u]];
+                }
+                ancestor[u] = ancestor[ancestor[u]];
+            }
+            return label[v];
+        };
+        for (int32_t w = count - 1; w > 0; --w) {
+            for (Block *pred : vertex[w]->preds) {
+                int32_t v = number[pred->id];
+                if (v != -1) {
+                    semi[w] = std::min(semi[w], semi[eval(v)]);
+                }
+            }
+            bucket[semi[w]].push_back(w);
+            ancestor[w] = parent[w];
+            for (int32_t v : bucket[parent[w]]) {
+                int32_t u = eval(v);
+                idom[v] = semi[u] < semi[v] ? u : parent[w];
+            }
+            bucket[parent[w]].clear();
+        }
+        for (int32_t w = 1; w < count; ++w) {
+            if (idom[w] != semi[w]) {
+                idom[w] = idom[idom[w]];
+            }
+            Block *dominator = vertex[idom[w]];
+            idoms[vertex[w]->id] = dominator;
+            tree[dominator->id].push_back(vertex[w]);
+        }
+
+        // Preorder and postorder numbers of the tree
+        int32_t clock = 0;
+        std::vector<std::pair<Block *, size_t>> walk = {{blocks[0], 0}};
+        enter[0] = clock++;
+        while (!walk.empty()) {
+            Block *block = walk.back().first;
+            size_t next = walk.back().second++;
+            if (next == tree[block->id].size()) {
+                exit[block->id] = clock++;
+                walk.pop_back();
+                continue;
+            }
+            Block *child = tree[block->id][next];
+            enter[child->id] = clock++;
+            walk.emplace_back(child, 0);
+        }
+    }
+
+    std::vector<std::vector<Block *>> DominatorTree::frontiers(const Function &function) const {
+        std::vector<std::vector<Block *>> frontier(function.blocks.size());
+        for (Block *block : function.blocks) {
+            if (block->preds.size() < 2 || enter[block->id] == -1) {
+                continue;
+            }
+            // Every block from a predecessor up to the immediate dominator (excluded) has the join in its frontier
+            for (Block *pred : block->preds) {
+                if (enter[pred->id] == -1) {
+                    continue;
+                }
+                for (Block *runner = pred; runner != idoms[block->id]; runner = idoms[runner->id]) {
+                    std::vector<Block *> &blocks = frontier[runner->id];
+                    if (blocks.empty() || blocks.back() != block) {
+                        blocks.push_back(block);
+                    }
+                }
+            }
+        }
+        return frontier;
+    }
+
+    /* Verifier */
+
+    bool verify(const Function &function, std::ostream &errors) {
+        bool ok = true;
+        auto error = [&](const Block *block, const std::string &message) {
+            errors << function.name << ": b" << block->id << ": " << message << std::endl;
+            ok = false;
+        };
+
+        // Where every value is: its instruction, by id
+        std::vector<const Instruction *> placed(function.valueCount(), nullptr);
+        std::vector<int32_t> position(function.valueCount(), -1);
+        for (size_t b = 0; b < function.blocks.size(); ++b) {
+            const Block *block = function.blocks[b];
+            if (block->id != static_cast<int32_t>(b)) {
+                error(block, "is numbered as b" + std::to_string(block->id) + " at position " + std::to_string(b));
+                return false;
+            }
+            for (size_t i = 0; i < block->instructions.size(); ++i) {
+                const Instruction *instruction = block->instructions[i];
+                if (instruction->id < 0 || instruction->id >= function.valueCount() || placed[instruction->id]) {
+                    error(block, "value %" + std::to_string(instruction->id) + " is defined twice or out of range");
+                    return false;
+                }
+                placed[instruction->id] = instruction;
+                position[instruction->id] = static_cast<int32_t>(i);
+            }
+        }
+
+        // The shape of the blocks, and the edges
+        for (const Block *block : function.blocks) {
+            const Instruction *terminator = block->terminator();
+            if (!terminator) {
+                error(block, "does not end with a terminator");
+                continue;
+            }
+            bool phis = true;
+            for (const Instruction *instruction : block->instructions) {
+                if (instruction->block != block) {
+                    error(block, "holds %" + std::to_string(instruction->id) + " of another block");
+                }
+                if (instruction->isTerminator() && instruction != terminator) {
+                    error(block, "has a terminator before its end");
+                }
+                if (instruction->opcode == Opcode::LOAD || instruction->opcode == Opcode::STORE) {
+                    error(block, std::string("has a ") + opcodeName(instruction->opcode) + " of a variable");
+                }
+                if (instruction->opcode != Opcode::PHI) {
+                    phis = false;
+                } else if (!phis) {
+                    error(block, "has a phi after other instructions");
+                } else if (instruction->operands.size() != block->preds.size()) {
+                    error(block, "has a phi %" + std::to_string(instruction->id) + " with " +
+                                 std::to_string(instruction->operands.size()) + " operands for " +
+                                 std::to_string(block->preds.size()) + " predecessors");
+                }
+            }
+            size_t targets = terminator->opcode == Opcode::JUMP ? 1 : terminator->opcode == Opcode::BRANCH ? 2 : 0;
+            bool edges = block->succs.size() == targets;
+            for (size_t i = 0; edges && i < targets; ++i) {
+                edges = block->succs[i] == terminator->targets[i];
+            }
+            if (!edges) {
+                error(block, "has successors that do not match its terminator");
+            }
+            for (const Block *succ : block->succs) {
+                size_t back = 0;
+                for (const Block *pred : succ->preds) {
+                    back += pred == block;
+                }
+                size_t forward = 0;
+                for (const Block *other : block->succs) {
+                    forward += other == succ;
+                }
+                if (back != forward) {
+                    error(block, "is not a predecessor of its successor b" + std::to_string(succ->id));
+                }
+            }
+        }
+        if (!ok) {
+            return false;
+        }
+        if (!function.blocks.empty() && !function.blocks[0]->preds.empty()) {
+            error(function.blocks[0], "is the entry, and has predecessors");
+        }
+
+        // Every value dominates its uses. A phi uses its operands at the end of the matching predecessor
+        DominatorTree dominators(function);
+        for (const Block *block : function.blocks) {
+            if (block != function.blocks[0] && !dominators.idom(block)) {
+                error(block, "is unreachable");
+                continue;
+            }
+            for (size_t i = 0; i < block->instructions.size(); ++i) {
+                const Instruction *instruction = block->instructions[i];
+                for (size_t j = 0; j < instruction->operands.size(); ++j) {
+                    const Instruction *operand = instruction->operands[j];
+                    std::string use = "%" + std::to_string(instruction->id) + " uses ";
+                    if (!operand) {
+                        error(block, use + "no value");
+                        continue;
+                    }
+                    if (operand->id < 0 || operand->id >= function.valueCount() || placed[operand->id] != operand) {
+                        error(block, use + "%" + std::to_string(operand->id) + ", which is in no block");
+                        continue;
+                    }
+                    if (operand->type == ast::BuiltInType::VOID) {
+                        error(block, use + "%" + std::to_string(operand->id) + ", which has no value");
+                    }
+                    bool phi = instruction->opcode == Opcode::PHI;
+                    const Block *at = phi ? block->preds[j] : block;
+                    bool dominated = operand->block == at
+                                     ? phi || position[operand->id] < static_cast<int32_t>(i)
+                                     : dominators.dominates(operand->block, at);
+                    if (!dominated) {
+                        error(block, use + "%" + std::to_string(operand->id) + ", which does not dominate it");
+                    }
+                }
+            }
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,173 @@
+#ifndef IR_HPP
+#define IR_HPP
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nodes.hpp"
+#include "interner.hpp"
+
+namespace ir {
+
+    /* Instructions of the IR. The operands of an instruction are the values of other instructions.
+     * LOAD and STORE read and write the variables of the function; they only exist until the SSA form is built,
+     * which replaces them with the values stored and PHI instructions. A block ends with exactly one of the
+     * terminators JUMP, BRANCH and RETURN.
+     */
+    enum class Opcode {
+        CONST,   // the immediate
+        PARAM,   // the argument of index immediate
+        PHI,     // one operand for every predecessor of its block, in the same order
+        LOAD,    // the variable of index immediate
+        STORE,   // store the operand in the variable of index immediate
+        ADD,     // int arithmetic, wrapping at 32 bits
+        SUB,
+        MUL,
+        DIV,
+        TRUNC,   // wrap to a byte
+        EQ,
+        NE,
+        LT,
+        GT,
+        LE,
+        GE,
+        NOT,
+        CALL,    // call the function `callee` with the operands, printi included
+        PRINT,   // print the string
+        JUMP,
+        BRANCH,  // to the first target if the operand is true, to the second one otherwise
+        RETURN   // with the operand, if any
+    };
+
+    // Name of the opcode, as printed in the dumps
+    const char *opcodeName(Opcode opcode);
+
+    class Block;
+
+    /* An instruction, which is also the value it computes */
+    struct Instruction {
+        Opcode opcode;
+        // Number of the value, unique in its function
+        int32_t id;
+        // Type of the value, VOID for the instructions without one
+        ast::BuiltInType type;
+        std::vector<Instruction *> operands;
+        // Constant (CONST), argument (PARAM) or variable (PHI, LOAD, STORE)
+        int32_t immediate;
+        // Function called (CALL)
+        Symbol callee;
+        // String printed (PRINT)
+        std::string_view string;
+        // Successors (JUMP, BRANCH)
+        Block *targets[2];
+        Block *block;
+
+        bool isTerminator() const {
+            return opcode == Opcode::JUMP || opcode == Opcode::BRANCH || opcode == Opcode::RETURN;
+        }
+    };
+
+    /* A basic block: its PHI instructions first, and a terminator last */
+    class Block {
+    public:
+        // Index of the block in its function
+        int32_t id;
+        std::vector<Instruction *> instructions;
+        std::vector<Block *> preds;
+        // In the order of the targets of the terminator
+        std::vector<Block *> succs;
+
+        Instruction *terminator() const {
+            return instructions.empty() || !instructions.back()->isTerminator() ? nullptr : instructions.back();
+        }
+    };
+
+    /* A variable of the source, or one holding the value of an And or an Or */
+    struct Variable {
+        std::string name;
+        ast::BuiltInType type;
+    };
+
+    /* A function: a control flow graph of blocks, entered through the first one */
+    class Function {
+    public:
+        Function(std::string name, int32_t params, ast::BuiltInType return_type);
+
+        Function(const Function &) = delete;
+
+        Function &operator=(const Function &) = delete;
+
+        std::string name;
+        int32_t params;
+        ast::BuiltInType return_type;
+        std::vector<Block *> blocks;
+        // Variables read and written by LOAD and STORE, by index
+        std::vector<Variable> variables;
+
+        Block *createBlock();
+
+        // Creates an instruction, in no block yet
+        Instruction *create(Opcode opcode, ast::BuiltInType type, std::vector<Instruction *> operands = {},
+                            int32_t immediate = 0);
+
+        // Number of values created so far, an upper bound of the ids
+        int32_t valueCount() const {
+            return next_value;
+        }
+
+        // Numbers the blocks by their position, and the values by their order in the blocks
+        void renumber();
+
+        // Prints the function, one instruction per line under the label of each block
+        void print(std::ostream &os) const;
+
+    private:
+        // Instructions and blocks keep their address as the function grows
+        std::deque<Instruction> instruction_storage;
+        std::deque<Block> block_storage;
+        int32_t next_value;
+    };
+
+    /* DominatorTree class
+     * Immediate dominators of the blocks of a function, by the Lengauer-Tarjan algorithm with path compression:
+     * O(E log V) on any graph. Every block must be reachable from the entry.
+     */
+    class DominatorTree {
+    public:
+        explicit DominatorTree(const Function &function);
+
+        // The immediate dominator of the block, nullptr for the entry
+        Block *idom(const Block *block) const {
+            return idoms[block->id];
+        }
+
+        const std::vector<Block *> &children(const Block *block) const {
+            return tree[block->id];
+        }
+
+        bool dominates(const Block *dominator, const Block *block) const {
+            return enter[dominator->id] <= enter[block->id] && exit[block->id] <= exit[dominator->id];
+        }
+
+        // Dominance frontier of every block: the blocks where its dominance stops
+        std::vector<std::vector<Block *>> frontiers(const Function &function) const;
+
+    private:
+        std::vector<Block *> idoms;
+        std::vector<std::vector<Block *>> tree;
+        // Preorder and postorder numbers in the tree, for the dominance queries
+        std::vector<int32_t> enter;
+        std::vector<int32_t> exit;
+    };
+
+    // Checks that the function is well formed and in SSA form: its blocks are reachable and end with a terminator
+    // that matches their successors, its PHIs match the predecessors, and every value dominates its uses. Prints
+    // every problem to `errors`, and returns whether there was none
+    bool verify(const Function &function, std::ostream &errors);
+}
+
+#endif //IR_HPP
@@ -0,0 +1,312 @@
+#include "ir_builder.hpp"
+
+/* Helper functions */
+
+static ir::Opcode arithmetic(ast::BinOpType op) {
+    switch (op) {
+        case ast::BinOpType::ADD:
+            return ir::Opcode::ADD;
+        case ast::BinOpType::SUB:
+            return ir::Opcode::SUB;
+        case ast::BinOpType::MUL:
+            return ir::Opcode::MUL;
+        default:
+            return ir::Opcode::DIV;
+    }
+}
+
+static ir::Opcode comparison(ast::RelOpType op) {
+    switch (op) {
+        case ast::RelOpType::EQ:
+            return ir::Opcode::EQ;
+        case ast::RelOpType::NE:
+            return ir::Opcode::NE;
+        case ast::RelOpType::LT:
+            return ir::Opcode::LT;
+        case ast::RelOpType::GT:
+            return ir::Opcode::GT;
+        case ast::RelOpType::LE:
+            return ir::Opcode::LE;
+        default:
+            return ir::Opcode::GE;
+    }
+}
+
+IrBuilder::IrBuilder()
+        : function(nullptr), current(nullptr), value(nullptr), type(ast::BuiltInType::VOID),
+          print_name(StringInterner::global().intern("print")) {}
+
+ir::Instruction *IrBuilder::expression(ast::Exp *exp) {
+    exp->accept(*this);
+    return value;
+}
+
+void IrBuilder::condition(ast::Exp *exp, ir::Block *if_true, ir::Block *if_false) {
+    switch (exp->kind) {
+        case ast::NodeKind::Bool:
+            jump(ast::cast<ast::Bool>(exp)->value ? if_true : if_false);
+            return;
+        case ast::NodeKind::Not:
+            condition(ast::cast<ast::Not>(exp)->exp, if_false, if_true);
+            return;
+        case ast::NodeKind::And: {
+            ast::And *node = ast::cast<ast::And>(exp);
+            ir::Block *right = function->createBlock();
+            condition(node->left, right, if_false);
+            current = right;
+            condition(node->right, if_true, if_false);
+            return;
+        }
+        case ast::NodeKind::Or: {
+            ast::Or *node = ast::cast<ast::Or>(exp);
+            ir::Block *right = function->createBlock();
+            condition(node->left, if_true, right);
+            current = right;
+            condition(node->right, if_true, if_false);
+            return;
+        }
+        default:
+            branch(expression(exp), if_true, if_false);
+    }
+}
+
+void IrBuilder::boolValue(ast::Exp *exp, const char *name) {
+    int32_t result = variable(name + std::to_string(function->variables.size()), ast::BuiltInType::BOOL);
+    ir::Block *if_true = function->createBlock();
+    ir::Block *if_false = function->createBlock();
+    ir::Block *join = function->createBlock();
+    condition(exp, if_true, if_false);
+    current = if_true;
+    append(ir::Opcode::STORE, ast::BuiltInType::VOID, {append(ir::Opcode::CONST, ast::BuiltInType::BOOL, {}, 1)},
+           result);
+    jump(join);
+    current = if_false;
+    append(ir::Opcode::STORE, ast::BuiltInType::VOID, {append(ir::Opcode::CONST, ast::BuiltInType::BOOL, {}, 0)},
+           result);
+    jump(join);
+    current = join;
+    value = append(ir::Opcode::LOAD, ast::BuiltInType::BOOL, {}, result);
+    type = ast::BuiltInType::BOOL;
+}
+
+ir::Instruction *IrBuilder::append(ir::Opcode opcode, ast::BuiltInType type,
+                                   std::vector<ir::Instruction *> operands, int32_t immediate) {
+    if (current->terminator()) {
+        current = function->createBlock();
+    }
+    ir::Instruction *instruction = function->create(opcode, type, std::move(operands), immediate);
+    instruction->block = current;
+    current->instructions.push_back(instruction);
+    return instruction;
+}
+
+void IrBuilder::jump(ir::Block *target) {
+    if (current->terminator()) {
+        return;
+    }
+    ir::Instruction *instruction = append(ir::Opcode::JUMP, ast::BuiltInType::VOID);
+    instruction->targets[0] = target;
+    current->succs.push_back(target);
+    target->preds.push_back(current);
+}
+
+void IrBuilder::branch(ir::Instruction *condition, ir::Block *if_true, ir::Block *if_false) {
+    ir::Instruction *instruction = append(ir::Opcode::BRANCH, ast::BuiltInType::VOID, {condition});
+    instruction->targets[0] = if_true;
+    instruction->targets[1] = if_false;
+    current->succs = {if_true, if_false};
+    if_true->preds.push_back(current);
+    if_false->preds.push_back(current);
+}
+
+int32_t IrBuilder::variable(const std::string &name, ast::BuiltInType type) {
+    function->variables.push_back({name, type});
+    return static_cast<int32_t>(function->variables.size() - 1);
+}
+
+void IrBuilder::visit(ast::Num &node) {
+    value = append(ir::Opcode::CONST, ast::BuiltInType::INT, {}, node.value);
+    type = ast::BuiltInType::INT;
+}
+
+void IrBuilder::visit(ast::NumB &node) {
+    value = append(ir::Opcode::CONST, ast::BuiltInType::BYTE, {}, node.value);
+    type = ast::BuiltInType::BYTE;
+}
+
+void IrBuilder::visit(ast::String &node) {}
+
+void IrBuilder::visit(ast::Bool &node) {
+    value = append(ir::Opcode::CONST, ast::BuiltInType::BOOL, {}, node.value);
+    type = ast::BuiltInType::BOOL;
+}
+
+void IrBuilder::visit(ast::ID &node) {
+    value = append(ir::Opcode::LOAD, node.variable->type, {}, variables.at(node.variable));
+    type = node.variable->type;
+}
+
+void IrBuilder::visit(ast::BinOp &node) {
+    ir::Instruction *left = expression(node.left);
+    ast::BuiltInType left_type = type;
+    ir::Instruction *right = expression(node.right);
+    bool is_byte = left_type == ast::BuiltInType::BYTE && type == ast::BuiltInType::BYTE;
+    type = is_byte ? ast::BuiltInType::BYTE : ast::BuiltInType::INT;
+    value = append(arithmetic(node.op), type, {left, right});
+    // The quotient of two bytes is a byte already
+    if (is_byte && node.op != ast::BinOpType::DIV) {
+        value = append(ir::Opcode::TRUNC, type, {value});
+    }
+}
+
+void IrBuilder::visit(ast::RelOp &node) {
+    ir::Instruction *left = expression(node.left);
+    ir::Instruction *right = expression(node.right);
+    value = append(comparison(node.op), ast::BuiltInType::BOOL, {left, right});
+    type = ast::BuiltInType::BOOL;
+}
+
+void IrBuilder::visit(ast::Not &node) {
+    value = append(ir::Opcode::NOT, ast::BuiltInType::BOOL, {expression(node.exp)});
+    type = ast::BuiltInType::BOOL;
+}
+
+void IrBuilder::visit(ast::And &node) {
+    boolValue(&node, "and");
+}
+
+void IrBuilder::visit(ast::Or &node) {
+    boolValue(&node, "or");
+}
+
+void IrBuilder::visit(ast::Type &node) {}
+
+void IrBuilder::visit(ast::Cast &node) {
+    ir::Instruction *exp = expression(node.exp);
+    if (node.target_type->type == ast::BuiltInType::BYTE && type != ast::BuiltInType::BYTE) {
+        value = append(ir::Opcode::TRUNC, ast::BuiltInType::BYTE, {exp});
+    }
+    // A byte is an int as it is
+    type = node.target_type->type;
+}
+
+void IrBuilder::visit(ast::ExpList &node) {}
+
+void IrBuilder::visit(ast::Call &node) {
+    if (node.func_id->name == print_name) {
+        value = append(ir::Opcode::PRINT, ast::BuiltInType::VOID);
+        value->string = ast::cast<ast::String>(node.args->exps[0])->value;
+        type = ast::BuiltInType::VOID;
+        return;
+    }
+    std::vector<ir::Instruction *> args;
+    for (ast::Exp *exp : node.args->exps) {
+        args.push_back(expression(exp));
+    }
+    value = append(ir::Opcode::CALL, node.func_id->function->return_type, std::move(args));
+    value->callee = node.func_id->name;
+    type = node.func_id->function->return_type;
+}
+
+void IrBuilder::visit(ast::Statements &node) {
+    for (ast::Statement *statement : node.statements) {
+        statement->accept(*this);
+    }
+}
+
+void IrBuilder::visit(ast::Break &node) {
+    jump(loops.back().exit);
+}
+
+void IrBuilder::visit(ast::Continue &node) {
+    jump(loops.back().header);
+}
+
+void IrBuilder::visit(ast::Return &node) {
+    if (node.exp) {
+        append(ir::Opcode::RETURN, ast::BuiltInType::VOID, {expression(node.exp)});
+    } else {
+        append(ir::Opcode::RETURN, ast::BuiltInType::VOID);
+    }
+}
+
+void IrBuilder::visit(ast::If &node) {
+    ir::Block *then = function->createBlock();
+    ir::Block *otherwise = node.otherwise ? function->createBlock() : nullptr;
+    ir::Block *join = function->createBlock();
+    condition(node.condition, then, otherwise ? otherwise : join);
+    current = then;
+    node.then->accept(*this);
+    jump(join);
+    if (otherwise) {
+        current = otherwise;
+        node.otherwise->accept(*this);
+        jump(join);
+    }
+    current = join;
+}
+
+void IrBuilder::visit(ast::While &node) {
+    ir::Block *header = function->createBlock();
+    ir::Block *body = function->createBlock();
+    ir::Block *exit = function->createBlock();
+    jump(header);
+    current = header;
+    condition(node.condition, body, exit);
+    current = body;
+    loops.push_back({header, exit});
+    node.body->accept(*this);
+    loops.pop_back();
+    jump(header);
+    current = exit;
+}
+
+void IrBuilder::visit(ast::VarDecl &node) {
+    ir::Instruction *init = node.init_exp ? expression(node.init_exp)
+                                          : append(ir::Opcode::CONST, node.id->variable->type, {}, 0);
+    int32_t index = variable(node.id->text(), node.id->variable->type);
+    variables[node.id->variable] = index;
+    append(ir::Opcode::STORE, ast::BuiltInType::VOID, {init}, index);
+}
+
+void IrBuilder::visit(ast::Assign &node) {
+    append(ir::Opcode::STORE, ast::BuiltInType::VOID, {expression(node.exp)}, variables.at(node.id->variable));
+}
+
+void IrBuilder::visit(ast::Formal &node) {}
+
+void IrBuilder::visit(ast::Formals &node) {}
+
+void IrBuilder::visit(ast::FuncDecl &node) {
+    std::vector<ast::Formal *> &formals = node.formals->formals;
+    functions.emplace_back(new ir::Function(node.id->text(), static_cast<int32_t>(formals.size()),
+                                            node.return_type->type));
+    function = functions.back().get();
+    current = function->createBlock();
+    variables.clear();
+
+    for (size_t i = 0; i < formals.size(); ++i) {
+        ir::Instruction *param = append(ir::Opcode::PARAM, formals[i]->type->type, {}, static_cast<int32_t>(i));
+        int32_t index = variable(formals[i]->id->text(), formals[i]->type->type);
+        variables[formals[i]->id->variable] = index;
+        append(ir::Opcode::STORE, ast::BuiltInType::VOID, {param}, index);
+    }
+    node.body->accept(*this);
+
+    // Falling off the end of a function returns 0, or nothing
+    if (!current->terminator()) {
+        if (function->return_type != ast::BuiltInType::VOID) {
+            append(ir::Opcode::RETURN, ast::BuiltInType::VOID,
+                   {append(ir::Opcode::CONST, function->return_type, {}, 0)});
+        } else {
+            append(ir::Opcode::RETURN, ast::BuiltInType::VOID);
+        }
+    }
+    function = nullptr;
+}
+
+void IrBuilder::visit(ast::Funcs &node) {
+    for (ast::FuncDecl *func : node.funcs) {
+        func->accept(*this);
+    }
+}
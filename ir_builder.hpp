@@ -0,0 +1,119 @@
+#ifndef IR_BUILDER_HPP
+#define IR_BUILDER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "symbol_table.hpp"
+#include "ir.hpp"
+
+/* IrBuilder class
+ * Lowers the bodies of an analyzed program to control flow graphs (see ir.hpp), one per function, with every
+ * variable read and written through LOAD and STORE; ir::buildSsa then turns them to SSA form. Like the
+ * BytecodeCompiler, it needs a program analyzed without errors and not through a FunctionCache.
+ * Conditions lower to branches, short-circuit included; an And or Or used as a value is stored in a variable of its
+ * own in both branches. The statements after a break, a continue or a return go to a block without predecessors.
+ */
+class IrBuilder : public Visitor {
+public:
+    IrBuilder();
+
+    void visit(ast::Num &node) override;
+
+    void visit(ast::NumB &node) override;
+
+    void visit(ast::String &node) override;
+
+    void visit(ast::Bool &node) override;
+
+    void visit(ast::ID &node) override;
+
+    void visit(ast::BinOp &node) override;
+
+    void visit(ast::RelOp &node) override;
+
+    void visit(ast::Not &node) override;
+
+    void visit(ast::And &node) override;
+
+    void visit(ast::Or &node) override;
+
+    void visit(ast::Type &node) override;
+
+    void visit(ast::Cast &node) override;
+
+    void visit(ast::ExpList &node) override;
+
+    void visit(ast::Call &node) override;
+
+    void visit(ast::Statements &node) override;
+
+    void visit(ast::Break &node) override;
+
+    void visit(ast::Continue &node) override;
+
+    void visit(ast::Return &node) override;
+
+    void visit(ast::If &node) override;
+
+    void visit(ast::While &node) override;
+
+    void visit(ast::VarDecl &node) override;
+
+    void visit(ast::Assign &node) override;
+
+    void visit(ast::Formal &node) override;
+
+    void visit(ast::Formals &node) override;
+
+    void visit(ast::FuncDecl &node) override;
+
+    void visit(ast::Funcs &node) override;
+
+    // The lowered functions, in the order of the program
+    std::vector<std::unique_ptr<ir::Function>> functions;
+
+private:
+    // A loop being lowered: where its continues and its breaks go
+    struct Loop {
+        ir::Block *header;
+        ir::Block *exit;
+    };
+
+    // Lowers the expression, and returns its value. Its type is left in `type`
+    ir::Instruction *expression(ast::Exp *exp);
+
+    // Lowers the condition as branches to `if_true` and `if_false`
+    void condition(ast::Exp *exp, ir::Block *if_true, ir::Block *if_false);
+
+    // Lowers an And or an Or as a value
+    void boolValue(ast::Exp *exp, const char *name);
+
+    // Appends the instruction to the current block, or to a new unreachable one if that block is terminated
+    ir::Instruction *append(ir::Opcode opcode, ast::BuiltInType type, std::vector<ir::Instruction *> operands = {},
+                            int32_t immediate = 0);
+
+    // Ends the current block, unless a break, a continue or a return ended it already
+    void jump(ir::Block *target);
+
+    void branch(ir::Instruction *condition, ir::Block *if_true, ir::Block *if_false);
+
+    // Adds a variable to the function, and returns its index
+    int32_t variable(const std::string &name, ast::BuiltInType type);
+
+    ir::Function *function;
+    ir::Block *current;
+    // Variables of the function being lowered
+    std::unordered_map<const SymbolEntry *, int32_t> variables;
+    std::vector<Loop> loops;
+    // The last lowered expression
+    ir::Instruction *value;
+    ast::BuiltInType type;
+    Symbol print_name;
+};
+
+#endif //IR_BUILDER_HPP
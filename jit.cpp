@@ -0,0 +1,684 @@
+#include "jit.hpp"
+#include "virtual_machine.hpp"
+
+// Native code is only generated for the System V x86-64 ABI
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_NATIVE 1
+#else
+#define JIT_NATIVE 0
+#endif
+
+#if JIT_NATIVE
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+
+/* Helper functions */
+
+namespace {
+
+    enum Register {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15
+    };
+
+    // Condition codes of the jcc and setcc instructions. The opposite of a condition flips its lowest bit
+    enum Condition {
+        BELOW = 0x2, EQUAL = 0x4, NOT_EQUAL = 0x5, LESS = 0xC, GREATER_EQUAL = 0xD, LESS_EQUAL = 0xE, GREATER = 0xF
+    };
+
+    // Extension of the group 1 instructions (opcode 0x81) with an immediate operand
+    enum Group1 {
+        ADD_IMM = 0, AND_IMM = 4, SUB_IMM = 5, CMP_IMM = 7
+    };
+
+    // Operand registers, from the bottom of the operand stack of a call. The callee saved ones, so the print
+    // helpers keep them
+    const Register OPERAND_REGISTERS[] = {RBX, R12, R13, R14, R15};
+    const int32_t OPERAND_REGISTER_COUNT = sizeof(OPERAND_REGISTERS) / sizeof(OPERAND_REGISTERS[0]);
+
+    // Stack kept below the limit checked by the calls, for the print helpers
+    const size_t STACK_RESERVE = 64 << 10;
+
+    // Status returned by the entry stub
+    enum Status {
+        FINISHED, DIVISION_BY_ZERO, STACK_OVERFLOW
+    };
+
+    Condition condition(vm::Opcode comparison) {
+        switch (comparison) {
+            case vm::EQ:
+            case vm::JUMP_UNLESS_EQ:
+                return EQUAL;
+            case vm::NE:
+            case vm::JUMP_UNLESS_NE:
+                return NOT_EQUAL;
+            case vm::LT:
+            case vm::JUMP_UNLESS_LT:
+                return LESS;
+            case vm::GT:
+            case vm::JUMP_UNLESS_GT:
+                return GREATER;
+            case vm::LE:
+            case vm::JUMP_UNLESS_LE:
+                return LESS_EQUAL;
+            default:
+                return GREATER_EQUAL;
+        }
+    }
+
+    Condition opposite(Condition condition) {
+        return static_cast<Condition>(condition ^ 1);
+    }
+
+    /* Assembler class
+     * Encodes the few x86-64 instructions the Jit needs. Memory operands are always [rbp + disp32], and opcodes
+     * above 0xFF are two bytes long (0x0F and the second one).
+     */
+    class Assembler {
+    public:
+        std::vector<uint8_t> bytes;
+
+        size_t size() const {
+            return bytes.size();
+        }
+
+        void byte(uint8_t value) {
+            bytes.push_back(value);
+        }
+
+        void u32(uint32_t value) {
+            for (int i = 0; i < 4; ++i) {
+                byte(value >> (8 * i));
+            }
+        }
+
+        void u64(uint64_t value) {
+            for (int i = 0; i < 8; ++i) {
+                byte(value >> (8 * i));
+            }
+        }
+
+        // Instruction on the register `reg` and the register `rm`
+        void rr(uint16_t opcode, int reg, int rm, bool wide = false) {
+            prefix(opcode, wide, reg, rm);
+            byte(0xC0 | (reg & 7) << 3 | (rm & 7));
+        }
+
+        // Instruction on the register `reg` and [rbp + disp]
+        void rm(uint16_t opcode, int reg, int32_t disp, bool wide = false) {
+            prefix(opcode, wide, reg, RBP);
+            byte(0x80 | (reg & 7) << 3 | (RBP & 7));
+            u32(disp);
+        }
+
+        void movImm(Register reg, int32_t value) {
+            rex(false, 0, reg);
+            byte(0xB8 | (reg & 7));
+            u32(value);
+        }
+
+        void movImm64(Register reg, uint64_t value) {
+            rex(true, 0, reg);
+            byte(0xB8 | (reg & 7));
+            u64(value);
+        }
+
+        void push(Register reg) {
+            rex(false, 0, reg);
+            byte(0x50 | (reg & 7));
+        }
+
+        void pop(Register reg) {
+            rex(false, 0, reg);
+            byte(0x58 | (reg & 7));
+        }
+
+        // setcc al, movzx eax, al
+        void setBool(Condition condition) {
+            rr(0x0F90 | condition, 0, RAX);
+            rr(0x0FB6, RAX, RAX);
+        }
+
+        // Jumps with a 32-bit displacement, returning its position to patch
+        size_t jump() {
+            byte(0xE9);
+            u32(0);
+            return size() - 4;
+        }
+
+        size_t jump(Condition condition) {
+            byte(0x0F);
+            byte(0x80 | condition);
+            u32(0);
+            return size() - 4;
+        }
+
+        size_t call() {
+            byte(0xE8);
+            u32(0);
+            return size() - 4;
+        }
+
+        void patch(size_t position, size_t target) {
+            uint32_t displacement = static_cast<uint32_t>(target - (position + 4));
+            std::memcpy(&bytes[position], &displacement, 4);
+        }
+
+    private:
+        void rex(bool wide, int reg, int rm) {
+            uint8_t rex = 0x40 | wide << 3 | (reg & 8) >> 1 | (rm & 8) >> 3;
+            if (rex != 0x40) {
+                byte(rex);
+            }
+        }
+
+        void prefix(uint16_t opcode, bool wide, int reg, int rm) {
+            rex(wide, reg, rm);
+            if (opcode > 0xFF) {
+                byte(opcode >> 8);
+            }
+            byte(opcode & 0xFF);
+        }
+    };
+
+    /* NativeCompiler class
+     * Translates every function of a program, one bytecode instruction at a time. The depth of the operand stack
+     * before every instruction is known statically, so each operand has a fixed place: a register, or its own slot
+     * of the frame. A frame is laid out by the System V convention: the arguments pushed by the caller above the
+     * return address, the saved rbp, then the locals and the operands that do not fit in registers.
+     */
+    class NativeCompiler {
+    public:
+        // A print builtin of the Jit
+        typedef void (*Helper)(vm::Jit *, int32_t);
+
+        NativeCompiler(const vm::Program &program, vm::Jit *jit, uint64_t *saved_rsp, uint64_t stack_top,
+                       uint64_t stack_limit, Helper print, Helper printi)
+                : program(program), jit(jit), stack_limit(stack_limit), print(print), printi(printi),
+                  entries(program.functions.size()), native(program.code.size()) {
+            compileEntry(saved_rsp, stack_top);
+            for (size_t i = 0; i < program.functions.size(); ++i) {
+                compileFunction(i);
+            }
+            for (const std::pair<size_t, int32_t> &call : calls) {
+                a.patch(call.first, entries[call.second]);
+            }
+        }
+
+        Assembler a;
+
+    private:
+        // Where an operand or a local lives
+        struct Place {
+            bool in_register;
+            Register reg;
+            int32_t disp;
+        };
+
+        // Entry stub: saves the registers of its caller, switches to the stack of the program and calls main. It
+        // returns FINISHED, or the status of the error stub that stopped the program
+        void compileEntry(uint64_t *saved_rsp, uint64_t stack_top) {
+            static const Register SAVED[] = {RBP, RBX, R12, R13, R14, R15};
+            for (Register reg : SAVED) {
+                a.push(reg);
+            }
+            a.movImm64(RAX, reinterpret_cast<uint64_t>(saved_rsp));
+            a.byte(0x48), a.byte(0x89), a.byte(0x20);  // mov [rax], rsp
+            a.movImm64(RAX, stack_top);
+            a.rr(0x89, RAX, RSP, true);
+            calls.emplace_back(a.call(), program.main);
+            a.rr(0x31, RAX, RAX);
+
+            size_t restore = a.size();
+            a.movImm64(RCX, reinterpret_cast<uint64_t>(saved_rsp));
+            a.byte(0x48), a.byte(0x8B), a.byte(0x21);  // mov rsp, [rcx]
+            for (int i = sizeof(SAVED) / sizeof(SAVED[0]) - 1; i >= 0; --i) {
+                a.pop(SAVED[i]);
+            }
+            a.byte(0xC3);
+
+            division_by_zero = a.size();
+            a.movImm(RAX, DIVISION_BY_ZERO);
+            a.patch(a.jump(), restore);
+            stack_overflow = a.size();
+            a.movImm(RAX, STACK_OVERFLOW);
+            a.patch(a.jump(), restore);
+        }
+
+        // Depth of the operand stack before every instruction of the function, or -1 where it is unreachable
+        std::vector<int32_t> depths(const vm::Function &function, size_t end) const {
+            std::vector<int32_t> depth(end - function.entry, -1);
+            std::vector<std::pair<size_t, int32_t>> pending = {{function.entry, 0}};
+            while (!pending.empty()) {
+                size_t pc = pending.back().first;
+                int32_t before = pending.back().second;
+                pending.pop_back();
+                if (depth[pc - function.entry] != -1) {
+                    if (depth[pc - function.entry] != before) {
+                        throw std::logic_error("inconsistent operand stack in " + function.name);
+                    }
+                    continue;
+                }
+                depth[pc - function.entry] = before;
+
+                vm::Opcode opcode = static_cast<vm::Opcode>(program.code[pc]);
+                size_t next = pc + 1 + vm::operandCount(opcode);
+                int32_t after = before + vm::stackEffect(opcode);
+                if (opcode == vm::CALL) {
+                    const vm::Function &callee = program.functions[program.code[pc + 1]];
+                    after = before - callee.params + callee.returns_value;
+                }
+                switch (opcode) {
+                    case vm::JUMP:
+                        pending.emplace_back(program.code[pc + 1], after);
+                        break;
+                    case vm::JUMP_IF_FALSE:
+                    case vm::JUMP_IF_TRUE:
+                    case vm::JUMP_UNLESS_EQ:
+                    case vm::JUMP_UNLESS_NE:
+                    case vm::JUMP_UNLESS_LT:
+                    case vm::JUMP_UNLESS_GT:
+                    case vm::JUMP_UNLESS_LE:
+                    case vm::JUMP_UNLESS_GE:
+                        pending.emplace_back(program.code[pc + 1], after);
+                        pending.emplace_back(next, after);
+                        break;
+                    case vm::RET:
+                    case vm::RET_VALUE:
+                    case vm::HALT:
+                        break;
+                    default:
+                        pending.emplace_back(next, after);
+                }
+            }
+            return depth;
+        }
+
+        void compileFunction(size_t index) {
+            const vm::Function &function = program.functions[index];
+            size_t end = program.end(function);
+            std::vector<int32_t> depth = depths(function, end);
+            int32_t max_stack = function.max_stack;
+            for (int32_t before : depth) {
+                max_stack = std::max(max_stack, before + 2);
+            }
+            params = function.params;
+            locals = function.frame_size - function.params;
+
+            // rsp stays 16 byte aligned below the frame, for the calls to the print helpers
+            int32_t frame = 8 * (locals + max_stack);
+            if ((frame - 8 * params) % 16 != 0) {
+                frame += 8;
+            }
+            entries[index] = a.size();
+            a.push(RBP);
+            a.rr(0x89, RSP, RBP, true);
+            a.rr(0x81, SUB_IMM, RSP, true), a.u32(frame);
+            a.movImm64(RAX, stack_limit);
+            a.rr(0x39, RAX, RSP, true);
+            a.patch(a.jump(BELOW), stack_overflow);
+            // Locals start at 0
+            if (locals <= 4) {
+                for (int32_t slot = params; slot < function.frame_size; ++slot) {
+                    a.rm(0xC7, 0, local(slot).disp), a.u32(0);
+                }
+            } else {
+                a.rm(0x8D, RDI, local(function.frame_size - 1).disp, true);
+                a.movImm(RCX, locals);
+                a.rr(0x31, RAX, RAX);
+                a.byte(0xF3), a.byte(0x48), a.byte(0xAB);  // rep stosq
+            }
+
+            jumps.clear();
+            for (size_t pc = function.entry; pc < end;) {
+                vm::Opcode opcode = static_cast<vm::Opcode>(program.code[pc]);
+                int32_t before = depth[pc - function.entry];
+                native[pc] = a.size();
+                if (before != -1) {
+                    compileInstruction(opcode, &program.code[pc + 1], before);
+                }
+                pc += 1 + vm::operandCount(opcode);
+            }
+            for (const std::pair<size_t, int32_t> &jump : jumps) {
+                a.patch(jump.first, native[jump.second]);
+            }
+        }
+
+        void compileInstruction(vm::Opcode opcode, const int32_t *operands, int32_t depth) {
+            Place top = operand(depth - 1);
+            Place second = operand(depth - 2);
+            switch (opcode) {
+                case vm::PUSH:
+                    movImm(operand(depth), operands[0]);
+                    break;
+                case vm::LOAD:
+                    move(operand(depth), local(operands[0]));
+                    break;
+                case vm::STORE:
+                    move(local(operands[0]), top);
+                    break;
+                case vm::POP:
+                    break;
+                case vm::ADD:
+                    alu(0x01, 0x03, second, top);
+                    break;
+                case vm::SUB:
+                    alu(0x29, 0x2B, second, top);
+                    break;
+                case vm::MUL:
+                    if (second.in_register) {
+                        instruction(0x0FAF, second.reg, top);
+                    } else {
+                        load(RAX, second);
+                        instruction(0x0FAF, RAX, top);
+                        store(second, RAX);
+                    }
+                    break;
+                case vm::DIV:
+                    compileDivision(second, top);
+                    break;
+                case vm::TRUNC:
+                    aluImm(AND_IMM, top, 0xFF);
+                    break;
+                case vm::EQ:
+                case vm::NE:
+                case vm::LT:
+                case vm::GT:
+                case vm::LE:
+                case vm::GE:
+                    alu(0x39, 0x3B, second, top);
+                    a.setBool(condition(opcode));
+                    store(second, RAX);
+                    break;
+                case vm::NOT:
+                    aluImm(CMP_IMM, top, 0);
+                    a.setBool(EQUAL);
+                    store(top, RAX);
+                    break;
+                case vm::JUMP:
+                    jumps.emplace_back(a.jump(), operands[0]);
+                    break;
+                case vm::JUMP_IF_FALSE:
+                case vm::JUMP_IF_TRUE:
+                    aluImm(CMP_IMM, top, 0);
+                    jumps.emplace_back(a.jump(opcode == vm::JUMP_IF_FALSE ? EQUAL : NOT_EQUAL), operands[0]);
+                    break;
+                case vm::CALL:
+                    compileCall(operands[0], depth);
+                    break;
+                case vm::RET_VALUE:
+                    load(RAX, top);
+                    // Fall through
+                case vm::RET:
+                    a.rr(0x89, RBP, RSP, true);
+                    a.pop(RBP);
+                    a.byte(0xC3);
+                    break;
+                case vm::PRINT:
+                    a.movImm(RSI, operands[0]);
+                    callHelper(print);
+                    break;
+                case vm::PRINTI:
+                    load(RSI, top);
+                    callHelper(printi);
+                    break;
+                case vm::HALT:
+                    break;
+                case vm::LOAD2:
+                    move(operand(depth), local(operands[0]));
+                    move(operand(depth + 1), local(operands[1]));
+                    break;
+                case vm::ADD_CONST:
+                    aluImm(ADD_IMM, top, operands[0]);
+                    break;
+                case vm::INC_LOCAL:
+                    aluImm(ADD_IMM, local(operands[0]), operands[1]);
+                    break;
+                default:
+                    // The fused comparisons and jumps
+                    alu(0x39, 0x3B, second, top);
+                    jumps.emplace_back(a.jump(opposite(condition(opcode))), operands[0]);
+            }
+        }
+
+        // Divides `dividend` by `divisor` in place: idiv, apart from 0 (the error stub) and -1 (a negation, as
+        // INT_MIN / -1 traps)
+        void compileDivision(const Place &dividend, const Place &divisor) {
+            load(RCX, divisor);
+            load(RAX, dividend);
+            a.rr(0x85, RCX, RCX);
+            a.patch(a.jump(EQUAL), division_by_zero);
+            a.rr(0x81, CMP_IMM, RCX), a.u32(-1);
+            size_t negate = a.jump(EQUAL);
+            a.byte(0x99);  // cdq
+            a.rr(0xF7, 7, RCX);
+            size_t done = a.jump();
+            a.patch(negate, a.size());
+            a.rr(0xF7, 3, RAX);
+            a.patch(done, a.size());
+            store(dividend, RAX);
+        }
+
+        // The operands below the arguments are saved around the call, the callee owns all the registers
+        void compileCall(int32_t index, int32_t depth) {
+            const vm::Function &callee = program.functions[index];
+            int32_t first_argument = depth - callee.params;
+            int32_t saved = std::min(first_argument, OPERAND_REGISTER_COUNT);
+            for (int32_t i = 0; i < saved; ++i) {
+                a.rm(0x89, OPERAND_REGISTERS[i], home(i));
+            }
+            for (int32_t i = first_argument; i < depth; ++i) {
+                Place argument = operand(i);
+                if (argument.in_register) {
+                    a.push(argument.reg);
+                } else {
+                    a.rm(0xFF, 6, argument.disp);
+                }
+            }
+            calls.emplace_back(a.call(), index);
+            if (callee.params > 0) {
+                a.rr(0x81, ADD_IMM, RSP, true), a.u32(8 * callee.params);
+            }
+            for (int32_t i = 0; i < saved; ++i) {
+                a.rm(0x8B, OPERAND_REGISTERS[i], home(i));
+            }
+            if (callee.returns_value) {
+                store(operand(first_argument), RAX);
+            }
+        }
+
+        // Calls a print helper on the Jit and esi. rsp is aligned between instructions
+        void callHelper(Helper helper) {
+            a.movImm64(RDI, reinterpret_cast<uint64_t>(jit));
+            a.movImm64(RAX, reinterpret_cast<uint64_t>(helper));
+            a.rr(0xFF, 2, RAX);
+        }
+
+        // Slot of the frame for the operand at the given depth, when it is not in a register
+        int32_t home(int32_t depth) const {
+            return -8 * (locals + depth + 1);
+        }
+
+        Place operand(int32_t depth) const {
+            if (depth >= 0 && depth < OPERAND_REGISTER_COUNT) {
+                return {true, OPERAND_REGISTERS[depth], 0};
+            }
+            return {false, RAX, home(depth)};
+        }
+
+        // The arguments were pushed by the caller, the first one highest
+        Place local(int32_t slot) const {
+            if (slot < params) {
+                return {false, RAX, 16 + 8 * (params - 1 - slot)};
+            }
+            return {false, RAX, -8 * (slot - params + 1)};
+        }
+
+        // Instruction on a register and a place, with its r32, r/m32 opcode
+        void instruction(uint16_t opcode, Register reg, const Place &place) {
+            if (place.in_register) {
+                a.rr(opcode, reg, place.reg);
+            } else {
+                a.rm(opcode, reg, place.disp);
+            }
+        }
+
+        void load(Register reg, const Place &place) {
+            instruction(0x8B, reg, place);
+        }
+
+        void store(const Place &place, Register reg) {
+            if (place.in_register) {
+                a.rr(0x89, reg, place.reg);
+            } else {
+                a.rm(0x89, reg, place.disp);
+            }
+        }
+
+        void move(const Place &to, const Place &from) {
+            if (to.in_register) {
+                load(to.reg, from);
+            } else if (from.in_register) {
+                store(to, from.reg);
+            } else {
+                load(RAX, from);
+                store(to, RAX);
+            }
+        }
+
+        void movImm(const Place &to, int32_t value) {
+            if (to.in_register) {
+                a.movImm(to.reg, value);
+            } else {
+                a.rm(0xC7, 0, to.disp), a.u32(value);
+            }
+        }
+
+        // `to` op= `from`, with the r/m32, r32 and the r32, r/m32 opcodes of the operation
+        void alu(uint16_t to_memory, uint16_t to_register, const Place &to, const Place &from) {
+            if (to.in_register) {
+                instruction(to_register, to.reg, from);
+            } else if (from.in_register) {
+                a.rm(to_memory, from.reg, to.disp);
+            } else {
+                load(RAX, from);
+                a.rm(to_memory, RAX, to.disp);
+            }
+        }
+
+        void aluImm(Group1 operation, const Place &to, int32_t value) {
+            if (to.in_register) {
+                a.rr(0x81, operation, to.reg);
+            } else {
+                a.rm(0x81, operation, to.disp);
+            }
+            a.u32(value);
+        }
+
+        const vm::Program &program;
+        vm::Jit *jit;
+        uint64_t stack_limit;
+        Helper print;
+        Helper printi;
+        // Start of the error stubs
+        size_t division_by_zero;
+        size_t stack_overflow;
+        // Native start of every function, and of every instruction of the program
+        std::vector<size_t> entries;
+        std::vector<size_t> native;
+        // Displacements to patch with the start of a function, or of an instruction of the function being compiled
+        std::vector<std::pair<size_t, int32_t>> calls;
+        std::vector<std::pair<size_t, int32_t>> jumps;
+        // Frame of the function being compiled
+        int32_t params;
+        int32_t locals;
+    };
+}
+
+namespace vm {
+
+    bool Jit::supported() {
+        return true;
+    }
+
+    Jit::Jit(const Program &program, size_t stack_size)
+            : program(program), code(nullptr), code_size(0), stack(nullptr), stack_size(stack_size), saved_rsp(0),
+              out(nullptr) {
+        stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (stack == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        uint64_t stack_bottom = reinterpret_cast<uint64_t>(stack);
+        uint64_t stack_top = (stack_bottom + stack_size) & ~uint64_t(15);
+        NativeCompiler compiler(program, this, &saved_rsp, stack_top, stack_bottom + STACK_RESERVE,
+                                &Jit::print, &Jit::printi);
+
+        // Written while writable, then only executable
+        code_size = compiler.a.size();
+        code = mmap(nullptr, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (code == MAP_FAILED) {
+            munmap(stack, stack_size);
+            throw std::bad_alloc();
+        }
+        std::memcpy(code, compiler.a.bytes.data(), code_size);
+        mprotect(code, code_size, PROT_READ | PROT_EXEC);
+    }
+
+    Jit::~Jit() {
+        munmap(code, code_size);
+        munmap(stack, stack_size);
+    }
+
+    bool Jit::run(std::ostream &out) {
+        this->out = &out;
+        switch (reinterpret_cast<int32_t (*)()>(code)()) {
+            case DIVISION_BY_ZERO:
+                out << "Error division by zero" << '\n';
+                return false;
+            case STACK_OVERFLOW:
+                out << "Error stack overflow" << '\n';
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    void Jit::print(Jit *jit, int32_t string) {
+        *jit->out << jit->program.strings[string] << '\n';
+    }
+
+    void Jit::printi(Jit *jit, int32_t value) {
+        *jit->out << value << '\n';
+    }
+}
+
+#else
+
+namespace vm {
+
+    bool Jit::supported() {
+        return false;
+    }
+
+    Jit::Jit(const Program &program, size_t stack_size)
+            : program(program), code(nullptr), code_size(0), stack(nullptr), stack_size(stack_size), saved_rsp(0),
+              out(nullptr) {}
+
+    Jit::~Jit() {}
+
+    bool Jit::run(std::ostream &out) {
+        return VirtualMachine(program).run(out);
+    }
+
+    void Jit::print(Jit *jit, int32_t string) {}
+
+    void Jit::printi(Jit *jit, int32_t value) {}
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "bytecode.hpp"
+
+namespace vm {
+
+    /* Jit class
+     * Runs a compiled program (see BytecodeCompiler) as x86-64 machine code. Every function is translated once, in
+     * memory mapped as executable, with the operand stack of the bytecode allocated to registers: the five lowest
+     * operands of a call live in callee saved registers, the next ones and the locals in its native frame.
+     * The program runs on a stack of its own, and behaves like on the VirtualMachine: the same output, and the same
+     * "Error division by zero" and "Error stack overflow" (not necessarily at the same depth). Where no native code
+     * can be generated (see supported), the program runs on the VirtualMachine instead.
+     */
+    class Jit {
+    public:
+        // Bytes of the stack the program runs on
+        static const size_t DEFAULT_STACK_SIZE = 64 << 20;
+
+        // Whether this machine runs native code: x86-64 Linux
+        static bool supported();
+
+        explicit Jit(const Program &program, size_t stack_size = DEFAULT_STACK_SIZE);
+
+        ~Jit();
+
+        Jit(const Jit &) = delete;
+
+        Jit &operator=(const Jit &) = delete;
+
+        // Runs the program from main, writing what it prints to `out`. Returns false if it stopped on a runtime
+        // error, which is printed to `out` as well
+        bool run(std::ostream &out);
+
+    private:
+        // Called by the native code for the print builtins
+        static void print(Jit *jit, int32_t string);
+
+        static void printi(Jit *jit, int32_t value);
+
+        const Program &program;
+        // The executable code, starting with the entry stub
+        void *code;
+        size_t code_size;
+        void *stack;
+        size_t stack_size;
+        // Stack pointer of the caller of the entry stub, restored when the program stops
+        uint64_t saved_rsp;
+        std::ostream *out;
+    };
+}
+
+#endif //JIT_HPP
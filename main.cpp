@@ -1,26 +1,282 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-#include "output.hpp"
-#include "nodes.hpp"
-#include "semantic_analayzer_visitor.hpp"
+#include "compilation.hpp"
+#include "compile_server.hpp"
+#include "time_report.hpp"
+#include "thread_pool.hpp"
 
-// Extern from the bison-generated parser
-extern int yyparse();
+/* Command line
+ *   hw3 [options] < program                            compiles the program read from stdin
+ *   hw3 [options] --input FILE                         compiles the program in FILE, mapped into memory
+ *   hw3 [options] [--jobs N] [--out-dir DIR] file...   compiles every file, on N threads (all cores by default)
+ *   hw3 [--cache-dir DIR] [--jobs N] --serve SOCKET    serves programs sent to SOCKET by client/hw3_client
+ * In batch mode the result of each file goes to DIR/<name>.out, or to stdout under a "==> file <==" header,
+ * in the order the files were given. With DIR, two files of the same name (in different directories) are an error.
+ * For a single program, --jobs N checks its function bodies on N threads.
+ * The server handles N connections at once (all cores by default) and keeps running until SIGINT or SIGTERM. It
+ * caches the function results in memory, or in DIR if given. The client passes the options of each request.
+ *
+ * Options
+ *   --all-errors    report every semantic error instead of only the first one
+ *   --check-only    print only the errors, and exit with status 1 if there are any
+ *   --cache-dir DIR keep the analysis of every function in DIR, and only analyze again the functions that changed
+ *   --cache-stats   print the hits, misses and time saved by the cache to stderr
+ *   --time-report   print the time of every phase, and the slowest functions, to stderr
+ *   --time-trace FILE
+ *                   write the same timings to FILE as a Chrome trace
+ *   --mem-report    print the memory taken by every AST node class and compiler structure to stderr
+ *   --fold-constants
+ *                   fold the constant expressions after the analysis, and print how many nodes that removed to
+ *                   stderr. A folded byte above 255 is an error. The cache is not used
+ *   --eliminate-dead-code
+ *                   remove the statements that can never run after the analysis (and the folding), and print what
+ *                   was removed to stderr. The scopes printed do not change
+ *   --run           run the program on the bytecode virtual machine, and print its output instead of the scopes
+ *   --jit           same, translating the bytecode to native code first (x86-64 Linux, elsewhere like --run)
+ *   --dump-bytecode print the bytecode of the program instead of the scopes
+ *   --emit-c        print the program translated to C instead of the scopes, to be compiled by the C compiler
+ *   --dump-ir       print the functions of the program in SSA form instead of the scopes
+ *   --frame-layout  print the frame of every function instead of the scopes: the slot of every variable, with the
+ *                   sibling scopes sharing theirs, the frame size and the deepest stack of its calls
+ */
 
-extern std::shared_ptr<ast::Node> program;
+static void usage() {
+    std::cerr << "usage: hw3 [options] < program" << std::endl;
+    std::cerr << "       hw3 [options] --input FILE" << std::endl;
+    std::cerr << "       hw3 [options] [--out-dir DIR] file..." << std::endl;
+    std::cerr << "       hw3 [--cache-dir DIR [--cache-stats]] [--jobs N] --serve SOCKET" << std::endl;
+    std::cerr << "options: [--all-errors] [--check-only] [--jobs N] [--cache-dir DIR [--cache-stats]]" << std::endl;
+    std::cerr << "         [--time-report] [--time-trace FILE] [--mem-report] [--fold-constants]" << std::endl;
+    std::cerr << "         [--eliminate-dead-code]" << std::endl;
+    std::cerr << "         [--run | --jit | --dump-bytecode | --emit-c | --dump-ir | --frame-layout]" << std::endl;
+    exit(1);
+}
 
-int main() {
-    // Parse the input. The result is stored in the global variable `program`
-    yyparse();
-    
-    if (!program) {
-        std::cerr << "Fatal: AST root is null after parsing." << std::endl;
-        return 1;
+// Name of the output file of the given input: its base name with the extension replaced by .out
+static std::string outputName(const std::string &path) {
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot != 0) {
+        name.erase(dot);
+    }
+    return name + ".out";
+}
+
+// Compiles every file on a pool of `jobs` threads. Returns false if a file could not be read or written, or in
+// check-only mode if a file has errors. With an output directory, nothing is compiled if two files would write the
+// same output
+static bool compileBatch(const std::vector<std::string> &files, size_t jobs, const std::string &out_dir,
+                         const CompileOptions &options) {
+    if (!out_dir.empty()) {
+        std::unordered_map<std::string, const std::string *> writers;
+        bool unique = true;
+        for (const std::string &file : files) {
+            auto inserted = writers.emplace(outputName(file), &file);
+            if (!inserted.second) {
+                std::cerr << "hw3: " << *inserted.first->second << " and " << file << " both write " << out_dir
+                          << "/" << inserted.first->first << std::endl;
+                unique = false;
+            }
+        }
+        if (!unique) {
+            return false;
+        }
+    }
+
+    std::vector<std::string> results(files.size());
+    std::vector<char> readable(files.size(), true);
+    std::vector<char> compiled(files.size(), true);
+
+    {
+        ThreadPool pool(jobs);
+        for (size_t i = 0; i < files.size(); ++i) {
+            pool.submit([&, i] {
+                SourceBuffer source;
+                {
+                    TimeScope read(options.time_report, "read", files[i]);
+                    readable[i] = source.map(files[i]);
+                }
+                if (!readable[i]) {
+                    return;
+                }
+                std::ostringstream out;
+                compiled[i] = compile(source, out, options);
+                results[i] = out.str();
+            });
+        }
+        pool.wait();
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!readable[i]) {
+            std::cerr << "hw3: cannot read " << files[i] << std::endl;
+            ok = false;
+            continue;
+        }
+        if (options.check_only && !compiled[i]) {
+            ok = false;
+        }
+        if (out_dir.empty()) {
+            std::cout << "==> " << files[i] << " <==" << std::endl << results[i];
+            continue;
+        }
+        std::string path = out_dir + "/" + outputName(files[i]);
+        std::ofstream out(path, std::ios::binary);
+        if (!(out << results[i])) {
+            std::cerr << "hw3: cannot write " << path << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    // 0 until given: all cores for a batch, one thread for a single program
+    size_t jobs = 0;
+    std::string out_dir;
+    std::string input;
+    std::string socket;
+    std::vector<std::string> files;
+    std::unique_ptr<FunctionCache> cache;
+    bool cache_stats = false;
+    bool time_summary = false;
+    std::string trace_path;
+    bool mem_summary = false;
+    FoldStats fold_stats;
+    DeadCodeStats dead_code_stats;
+    CompileOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--jobs") && i + 1 < argc) {
+            jobs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--all-errors")) {
+            options.all_errors = true;
+        } else if (!strcmp(argv[i], "--check-only")) {
+            options.check_only = true;
+        } else if (!strcmp(argv[i], "--cache-dir") && i + 1 < argc) {
+            cache.reset(new FunctionCache(argv[++i]));
+        } else if (!strcmp(argv[i], "--cache-stats")) {
+            cache_stats = true;
+        } else if (!strcmp(argv[i], "--time-report")) {
+            time_summary = true;
+        } else if (!strcmp(argv[i], "--time-trace") && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (!strcmp(argv[i], "--mem-report")) {
+            mem_summary = true;
+        } else if (!strcmp(argv[i], "--fold-constants")) {
+            options.fold = &fold_stats;
+        } else if (!strcmp(argv[i], "--eliminate-dead-code")) {
+            options.eliminate_dead_code = &dead_code_stats;
+        } else if (!strcmp(argv[i], "--run")) {
+            options.run = true;
+        } else if (!strcmp(argv[i], "--jit")) {
+            options.jit = true;
+        } else if (!strcmp(argv[i], "--dump-bytecode")) {
+            options.dump_bytecode = true;
+        } else if (!strcmp(argv[i], "--emit-c")) {
+            options.emit_c = true;
+        } else if (!strcmp(argv[i], "--dump-ir")) {
+            options.dump_ir = true;
+        } else if (!strcmp(argv[i], "--frame-layout")) {
+            options.frame_layout = true;
+        } else if (!strcmp(argv[i], "--input") && i + 1 < argc) {
+            input = argv[++i];
+        } else if (!strcmp(argv[i], "--serve") && i + 1 < argc) {
+            socket = argv[++i];
+        } else if (!strcmp(argv[i], "--out-dir") && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+        } else {
+            files.push_back(argv[i]);
+        }
     }
-    // Create the semantic visitor and run it over the AST
-    SemanticAnalayzerVisitor visitor; 
-    program->accept(visitor);
 
-    // Print the scope values
-    std::cout << visitor.scope_printer;
+    options.cache = cache.get();
+    if (cache_stats && !cache && socket.empty()) {
+        usage();
+    }
+
+    if (!socket.empty()) {
+        if (!files.empty() || !input.empty()) {
+            usage();
+        }
+        if (!cache) {
+            cache.reset(new FunctionCache());
+        }
+        bool ok = CompileServer(socket, jobs ? jobs : std::thread::hardware_concurrency(), *cache).run();
+        if (cache_stats) {
+            cache->printStats(std::cerr);
+        }
+        return ok ? 0 : 1;
+    }
+
+    std::unique_ptr<TimeReport> time_report;
+    if (time_summary || !trace_path.empty()) {
+        time_report.reset(new TimeReport());
+    }
+    options.time_report = time_report.get();
+    MemoryReport mem_report;
+    if (mem_summary) {
+        options.mem_report = &mem_report;
+    }
+
+    // Prints the statistics asked for, and returns the given exit status
+    auto finish = [&](int status) {
+        if (options.fold) {
+            fold_stats.print(std::cerr);
+        }
+        if (options.eliminate_dead_code) {
+            dead_code_stats.print(std::cerr);
+        }
+        if (cache_stats) {
+            cache->printStats(std::cerr);
+        }
+        if (time_summary) {
+            time_report->printSummary(std::cerr);
+        }
+        if (!trace_path.empty() && !time_report->writeTrace(trace_path)) {
+            std::cerr << "hw3: cannot write " << trace_path << std::endl;
+            status = 1;
+        }
+        if (mem_summary) {
+            mem_report.add("StringInterner", StringInterner::global().memoryUsage());
+            mem_report.print(std::cerr);
+        }
+        return status;
+    };
+
+    if (!files.empty()) {
+        bool ok = compileBatch(files, jobs ? jobs : std::thread::hardware_concurrency(), out_dir, options);
+        return finish(ok ? 0 : 1);
+    }
+
+    // Compile a single program, from the given file or from stdin, and print its scopes or its errors
+    options.jobs = jobs ? jobs : 1;
+    SourceBuffer source;
+    bool readable = true;
+    {
+        TimeScope read(time_report.get(), "read");
+        if (input.empty()) {
+            source.read(std::cin);
+        } else {
+            readable = source.map(input);
+        }
+    }
+    if (!readable) {
+        std::cerr << "hw3: cannot read " << input << std::endl;
+        return 1;
+    }
+    bool compiled = compile(source, std::cout, options);
+    return finish(options.check_only && !compiled ? 1 : 0);
 }
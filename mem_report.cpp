@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <sys/resource.h>
+
+#include "mem_report.hpp"
+#include "arena.hpp"
+
+/* Helper functions */
+
+// Class name and size of every node kind, in NodeKind order
+struct NodeClass {
+    const char *name;
+    size_t size;
+};
+
+static const NodeClass NODE_CLASSES[] = {
+        {"ast::Num", sizeof(ast::Num)},
+        {"ast::NumB", sizeof(ast::NumB)},
+        {"ast::String", sizeof(ast::String)},
+        {"ast::Bool", sizeof(ast::Bool)},
+        {"ast::ID", sizeof(ast::ID)},
+        {"ast::BinOp", sizeof(ast::BinOp)},
+        {"ast::RelOp", sizeof(ast::RelOp)},
+        {"ast::Not", sizeof(ast::Not)},
+        {"ast::And", sizeof(ast::And)},
+        {"ast::Or", sizeof(ast::Or)},
+        {"ast::Cast", sizeof(ast::Cast)},
+        {"ast::Call", sizeof(ast::Call)},
+        {"ast::Statements", sizeof(ast::Statements)},
+        {"ast::Break", sizeof(ast::Break)},
+        {"ast::Continue", sizeof(ast::Continue)},
+        {"ast::Return", sizeof(ast::Return)},
+        {"ast::If", sizeof(ast::If)},
+        {"ast::While", sizeof(ast::While)},
+        {"ast::VarDecl", sizeof(ast::VarDecl)},
+        {"ast::Assign", sizeof(ast::Assign)},
+        {"ast::Type", sizeof(ast::Type)},
+        {"ast::ExpList", sizeof(ast::ExpList)},
+        {"ast::Formal", sizeof(ast::Formal)},
+        {"ast::Formals", sizeof(ast::Formals)},
+        {"ast::FuncDecl", sizeof(ast::FuncDecl)},
+        {"ast::Funcs", sizeof(ast::Funcs)},
+};
+
+static const size_t NODE_KINDS = sizeof(NODE_CLASSES) / sizeof(NODE_CLASSES[0]);
+
+// Vector of child pointers of a list node, with its name, or nullptr if the node has none
+static const char *childVector(ast::Node *node, MemoryUsage &usage) {
+    switch (node->kind) {
+        case ast::NodeKind::ExpList:
+            usage = containerUsage(ast::cast<ast::ExpList>(node)->exps);
+            return "ast::ExpList::exps";
+        case ast::NodeKind::Statements:
+            usage = containerUsage(ast::cast<ast::Statements>(node)->statements);
+            return "ast::Statements::statements";
+        case ast::NodeKind::Formals:
+            usage = containerUsage(ast::cast<ast::Formals>(node)->formals);
+            return "ast::Formals::formals";
+        case ast::NodeKind::Funcs:
+            usage = containerUsage(ast::cast<ast::Funcs>(node)->funcs);
+            return "ast::Funcs::funcs";
+        default:
+            return nullptr;
+    }
+}
+
+/* MemoryReport class */
+
+void MemoryReport::add(const std::string &category, const MemoryUsage &usage) {
+    add(category, usage, false);
+}
+
+void MemoryReport::add(const std::string &category, const MemoryUsage &usage, bool in_arena) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Category &entry : categories) {
+        if (entry.name == category) {
+            entry.usage += usage;
+            return;
+        }
+    }
+    categories.push_back({category, usage, in_arena});
+}
+
+void MemoryReport::addArena(const ast::Arena &arena) {
+    MemoryUsage nodes[NODE_KINDS];
+    MemoryUsage vectors[NODE_KINDS];
+    const char *vector_names[NODE_KINDS] = {};
+    for (ast::Node *node : arena.allocatedNodes()) {
+        size_t kind = static_cast<size_t>(node->kind);
+        ++nodes[kind].objects;
+        nodes[kind].live_bytes += NODE_CLASSES[kind].size;
+        nodes[kind].peak_bytes += NODE_CLASSES[kind].size;
+
+        MemoryUsage children;
+        if (const char *name = childVector(node, children)) {
+            vector_names[kind] = name;
+            vectors[kind] += children;
+        }
+    }
+    for (size_t kind = 0; kind < NODE_KINDS; ++kind) {
+        if (nodes[kind].objects) {
+            add(NODE_CLASSES[kind].name, nodes[kind], true);
+        }
+    }
+    for (size_t kind = 0; kind < NODE_KINDS; ++kind) {
+        if (vector_names[kind]) {
+            add(vector_names[kind], vectors[kind]);
+        }
+    }
+    add("ast::Arena", arena.memoryUsage());
+}
+
+void MemoryReport::addProgram() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++programs;
+}
+
+void MemoryReport::print(std::ostream &os) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    char line[256];
+    snprintf(line, sizeof(line), "%-30s %12s %14s %14s\n", "memory", "objects", "live (bytes)", "peak (bytes)");
+    os << line;
+
+    MemoryUsage nodes;
+    MemoryUsage total;
+    for (const Category &entry : categories) {
+        snprintf(line, sizeof(line), "%-30s %12zu %14zu %14zu\n", entry.name.c_str(), entry.usage.objects,
+                 entry.usage.live_bytes, entry.usage.peak_bytes);
+        os << line;
+        (entry.in_arena ? nodes : total) += entry.usage;
+    }
+
+    // The nodes are held by the arena blocks, so they count toward the total through the arena
+    snprintf(line, sizeof(line), "%-30s %12zu %14zu %14zu\n", "all nodes (in the arena)", nodes.objects,
+             nodes.live_bytes, nodes.peak_bytes);
+    os << line;
+    snprintf(line, sizeof(line), "%-30s %12s %14zu %14zu\n", "total", "", total.live_bytes, total.peak_bytes);
+    os << line;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    snprintf(line, sizeof(line), "programs: %zu, peak resident size of the process: %ld KiB\n", programs,
+             usage.ru_maxrss);
+    os << line;
+}
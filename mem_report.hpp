@@ -0,0 +1,76 @@
+#ifndef MEM_REPORT_HPP
+#define MEM_REPORT_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Memory taken by one kind of objects. None of the structures accounted here shrinks before it is freed, so the
+ * memory they reserve is also the most they held: the peak.
+ */
+struct MemoryUsage {
+    size_t objects = 0;
+    // Bytes in use
+    size_t live_bytes = 0;
+    // Bytes reserved: in use, or held by the spare capacity of the containers
+    size_t peak_bytes = 0;
+
+    MemoryUsage &operator+=(const MemoryUsage &other) {
+        objects += other.objects;
+        live_bytes += other.live_bytes;
+        peak_bytes += other.peak_bytes;
+        return *this;
+    }
+};
+
+// Usage of the elements of a container: its size and capacity times the element size
+template <typename Container>
+MemoryUsage containerUsage(const Container &container) {
+    MemoryUsage usage;
+    usage.objects = container.size();
+    usage.live_bytes = container.size() * sizeof(typename Container::value_type);
+    usage.peak_bytes = container.capacity() * sizeof(typename Container::value_type);
+    return usage;
+}
+
+namespace ast {
+    class Arena;
+}
+
+/* MemoryReport class
+ * Memory taken by the compiler, by AST node class and by structure (arena, symbol tables, printer, interner),
+ * gathered at the end of every compilation, when it is at its largest. With several programs the categories add
+ * up. Categories may be added from several threads.
+ */
+class MemoryReport {
+public:
+    void add(const std::string &category, const MemoryUsage &usage);
+
+    // Adds the arena, every node in it by node class, and the vectors of child pointers of the list nodes
+    void addArena(const ast::Arena &arena);
+
+    // Counts one more compiled program
+    void addProgram();
+
+    // One line per category, then the totals and the peak resident size of the process
+    void print(std::ostream &os) const;
+
+private:
+    struct Category {
+        std::string name;
+        MemoryUsage usage;
+        // Held in the arena blocks, so already part of the arena
+        bool in_arena;
+    };
+
+    void add(const std::string &category, const MemoryUsage &usage, bool in_arena);
+
+    mutable std::mutex mutex;
+    // Categories in the order they were first added
+    std::vector<Category> categories;
+    size_t programs = 0;
+};
+
+#endif //MEM_REPORT_HPP
@@ -1,112 +1,233 @@
 #include "nodes.hpp"
+#include <charconv>
 #include <string>
-#include <utility>
-
-extern int yylineno;
+#include <system_error>
 
 namespace ast {
 
-    Node::Node() : line(yylineno) {}
-
-    Num::Num(const char *str) : Exp(), value(std::stoi(str)) {}
+    Node::Node(NodeKind kind) : line(0), kind(kind) {}
 
-    NumB::NumB(const char *str) : Exp(), value(std::stoi(str)) {}
+    // Parses the leading decimal digits of the text, without copying it. The scanner rejects the numbers too large
+    // for an int (see Num::fits)
+    static int parseNumber(std::string_view text) {
+        int value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
 
-    String::String(const char *str) : Exp(), value(str) {
-        // Remove the quotes
-        value = value.substr(1, value.size() - 2);
+    bool Num::fits(std::string_view text) {
+        int value = 0;
+        return std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc::result_out_of_range;
     }
 
-    Bool::Bool(bool value) : Exp(), value(value) {}
+    Num::Num(std::string_view text) : Node(NodeKind::Num), Exp(), value(parseNumber(text)) {}
+
+    Num::Num(int value) : Node(NodeKind::Num), Exp(), value(value) {}
+
+    NumB::NumB(std::string_view text) : Node(NodeKind::NumB), Exp(), value(parseNumber(text)) {}
+
+    NumB::NumB(int value) : Node(NodeKind::NumB), Exp(), value(value) {}
+
+    // Remove the quotes
+    String::String(std::string_view text) : Node(NodeKind::String), Exp(), value(text.substr(1, text.size() - 2)) {}
+
+    Bool::Bool(bool value) : Node(NodeKind::Bool), Exp(), value(value) {}
 
-    ID::ID(const char *str) : Exp(), value(str) {}
+    ID::ID(Symbol name) : Node(NodeKind::ID), Exp(), name(name), bound(false), variable(nullptr), function(nullptr) {}
 
-    BinOp::BinOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, BinOpType op)
-            : Exp(), left(std::move(left)), right(std::move(right)), op(op) {}
+    const std::string &ID::text() const {
+        return StringInterner::global().str(name);
+    }
+
+    BinOp::BinOp(Exp *left, Exp *right, BinOpType op)
+            : Node(NodeKind::BinOp), Exp(), left(left), right(right), op(op) {}
 
-    RelOp::RelOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, RelOpType op)
-            : Exp(), left(std::move(left)), right(std::move(right)), op(op) {}
+    RelOp::RelOp(Exp *left, Exp *right, RelOpType op)
+            : Node(NodeKind::RelOp), Exp(), left(left), right(right), op(op) {}
 
-    Type::Type(BuiltInType type) : Node(), type(type) {}
+    Type::Type(BuiltInType type) : Node(NodeKind::Type), type(type) {}
 
-    Cast::Cast(std::shared_ptr<Exp> exp, std::shared_ptr<Type> target_type)
-            : Exp(), exp(std::move(exp)), target_type(std::move(target_type)) {}
+    Cast::Cast(Exp *exp, Type *target_type)
+            : Node(NodeKind::Cast), Exp(), exp(exp), target_type(target_type) {}
 
-    Not::Not(std::shared_ptr<Exp> exp) : Exp(), exp(std::move(exp)) {}
+    Not::Not(Exp *exp) : Node(NodeKind::Not), Exp(), exp(exp) {}
 
-    And::And(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right)
-            : Exp(), left(std::move(left)), right(std::move(right)) {}
+    And::And(Exp *left, Exp *right)
+            : Node(NodeKind::And), Exp(), left(left), right(right) {}
 
-    Or::Or(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right)
-            : Exp(), left(std::move(left)), right(std::move(right)) {}
+    Or::Or(Exp *left, Exp *right)
+            : Node(NodeKind::Or), Exp(), left(left), right(right) {}
 
-    ExpList::ExpList(std::shared_ptr<Exp> exp) : Node(), exps({std::move(exp)}) {}
+    ExpList::ExpList() : Node(NodeKind::ExpList) {}
 
-    void ExpList::push_front(const std::shared_ptr<Exp> &exp) {
+    ExpList::ExpList(Exp *exp) : Node(NodeKind::ExpList), exps({exp}) {}
+
+    void ExpList::push_front(Exp *exp) {
         exps.insert(exps.begin(), exp);
     }
 
-    void ExpList::push_back(const std::shared_ptr<Exp> &exp) {
+    void ExpList::push_back(Exp *exp) {
         exps.push_back(exp);
     }
 
-    Call::Call(std::shared_ptr<ID> func_id, std::shared_ptr<ExpList> args)
-            : Exp(), func_id(std::move(func_id)), args(std::move(args)) {}
+    Call::Call(ID *func_id, ExpList *args)
+            : Node(NodeKind::Call), Exp(), func_id(func_id), args(args) {}
 
-    Call::Call(std::shared_ptr<ID> func_id)
-            : Exp(), func_id(std::move(func_id)), args(std::make_shared<ExpList>()) {}
+    Statements::Statements() : Node(NodeKind::Statements), Statement() {}
 
-    Statements::Statements(std::shared_ptr<Statement> statement) : Statement(), statements({std::move(statement)}) {}
+    Statements::Statements(Statement *statement)
+            : Node(NodeKind::Statements), Statement(), statements({statement}) {}
 
-    void Statements::push_front(const std::shared_ptr<Statement> &statement) {
+    void Statements::push_front(Statement *statement) {
         statements.insert(statements.begin(), statement);
     }
 
-    void Statements::push_back(const std::shared_ptr<Statement> &statement) {
+    void Statements::push_back(Statement *statement) {
         statements.push_back(statement);
     }
 
-    Return::Return(std::shared_ptr<Exp> exp) : Statement(), exp(std::move(exp)) {}
+    Break::Break() : Node(NodeKind::Break), Statement() {}
+
+    Continue::Continue() : Node(NodeKind::Continue), Statement() {}
 
-    If::If(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> then, std::shared_ptr<Statement> otherwise)
-            : Statement(), condition(std::move(condition)), then(std::move(then)), otherwise(std::move(otherwise)) {}
+    Return::Return(Exp *exp) : Node(NodeKind::Return), Statement(), exp(exp) {}
 
-    While::While(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> body)
-            : Statement(), condition(std::move(condition)),
-              body(std::move(body)) {}
+    If::If(Exp *condition, Statement *then, Statement *otherwise)
+            : Node(NodeKind::If), Statement(), condition(condition), then(then),
+              otherwise(otherwise) {}
 
-    VarDecl::VarDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> type, std::shared_ptr<Exp> init_exp)
-            : Statement(), id(std::move(std::move(id))), type(std::move(type)), init_exp(std::move(init_exp)) {}
+    While::While(Exp *condition, Statement *body)
+            : Node(NodeKind::While), Statement(), condition(condition),
+              body(body) {}
 
-    Assign::Assign(std::shared_ptr<ID> id, std::shared_ptr<Exp> exp)
-            : Statement(), id(std::move(id)), exp(std::move(exp)) {}
+    VarDecl::VarDecl(ID *id, Type *type, Exp *init_exp)
+            : Node(NodeKind::VarDecl), Statement(), id(id), type(type),
+              init_exp(init_exp) {}
 
-    Formal::Formal(std::shared_ptr<ID> id, std::shared_ptr<Type> type)
-            : Node(), id(std::move(id)), type(std::move(type)) {}
+    Assign::Assign(ID *id, Exp *exp)
+            : Node(NodeKind::Assign), Statement(), id(id), exp(exp) {}
 
-    Formals::Formals(std::shared_ptr<Formal> formal) : Node(), formals({std::move(formal)}) {}
+    Formal::Formal(ID *id, Type *type)
+            : Node(NodeKind::Formal), id(id), type(type) {}
 
-    void Formals::push_front(const std::shared_ptr<Formal> &formal) {
+    Formals::Formals() : Node(NodeKind::Formals) {}
+
+    Formals::Formals(Formal *formal) : Node(NodeKind::Formals), formals({formal}) {}
+
+    void Formals::push_front(Formal *formal) {
         formals.insert(formals.begin(), formal);
     }
 
-    void Formals::push_back(const std::shared_ptr<Formal> &formal) {
+    void Formals::push_back(Formal *formal) {
         formals.push_back(formal);
     }
 
-    FuncDecl::FuncDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> return_type, std::shared_ptr<Formals> formals,
-                       std::shared_ptr<Statements> body)
-            : Node(), id(std::move(id)), return_type(std::move(return_type)), formals(std::move(formals)),
-              body(std::move(body)) {}
+    FuncDecl::FuncDecl(ID *id, Type *return_type, Formals *formals,
+                       Statements *body)
+            : Node(NodeKind::FuncDecl), id(id), return_type(return_type),
+              formals(formals), body(body) {}
 
-    Funcs::Funcs(std::shared_ptr<FuncDecl> func) : Node(), funcs({std::move(func)}) {}
+    Funcs::Funcs() : Node(NodeKind::Funcs) {}
 
-    void Funcs::push_front(const std::shared_ptr<FuncDecl> &func) {
+    Funcs::Funcs(FuncDecl *func) : Node(NodeKind::Funcs), funcs({func}) {}
+
+    void Funcs::push_front(FuncDecl *func) {
         funcs.insert(funcs.begin(), func);
     }
 
-    void Funcs::push_back(const std::shared_ptr<FuncDecl> &func) {
+    void Funcs::push_back(FuncDecl *func) {
         funcs.push_back(func);
     }
 
-}
\ No newline at end of file
+    size_t countNodes(Node *node) {
+        switch (node->kind) {
+            case NodeKind::BinOp: {
+                auto bin_op = cast<BinOp>(node);
+                return 1 + countNodes(bin_op->left) + countNodes(bin_op->right);
+            }
+            case NodeKind::RelOp: {
+                auto rel_op = cast<RelOp>(node);
+                return 1 + countNodes(rel_op->left) + countNodes(rel_op->right);
+            }
+            case NodeKind::Not:
+                return 1 + countNodes(cast<Not>(node)->exp);
+            case NodeKind::And: {
+                auto and_node = cast<And>(node);
+                return 1 + countNodes(and_node->left) + countNodes(and_node->right);
+            }
+            case NodeKind::Or: {
+                auto or_node = cast<Or>(node);
+                return 1 + countNodes(or_node->left) + countNodes(or_node->right);
+            }
+            case NodeKind::Cast: {
+                auto cast_node = cast<Cast>(node);
+                return 1 + countNodes(cast_node->exp) + countNodes(cast_node->target_type);
+            }
+            case NodeKind::ExpList: {
+                size_t count = 1;
+                for (Exp *exp : cast<ExpList>(node)->exps) {
+                    count += countNodes(exp);
+                }
+                return count;
+            }
+            case NodeKind::Call: {
+                auto call = cast<Call>(node);
+                return 1 + countNodes(call->func_id) + countNodes(call->args);
+            }
+            case NodeKind::Statements: {
+                size_t count = 1;
+                for (Statement *statement : cast<Statements>(node)->statements) {
+                    count += countNodes(statement);
+                }
+                return count;
+            }
+            case NodeKind::Return: {
+                Exp *exp = cast<Return>(node)->exp;
+                return 1 + (exp ? countNodes(exp) : 0);
+            }
+            case NodeKind::If: {
+                auto if_node = cast<If>(node);
+                return 1 + countNodes(if_node->condition) + countNodes(if_node->then) +
+                       (if_node->otherwise ? countNodes(if_node->otherwise) : 0);
+            }
+            case NodeKind::While: {
+                auto while_node = cast<While>(node);
+                return 1 + countNodes(while_node->condition) + countNodes(while_node->body);
+            }
+            case NodeKind::VarDecl: {
+                auto var_decl = cast<VarDecl>(node);
+                return 1 + countNodes(var_decl->id) + countNodes(var_decl->type) +
+                       (var_decl->init_exp ? countNodes(var_decl->init_exp) : 0);
+            }
+            case NodeKind::Assign: {
+                auto assign = cast<Assign>(node);
+                return 1 + countNodes(assign->id) + countNodes(assign->exp);
+            }
+            case NodeKind::Formal: {
+                auto formal = cast<Formal>(node);
+                return 1 + countNodes(formal->id) + countNodes(formal->type);
+            }
+            case NodeKind::Formals: {
+                size_t count = 1;
+                for (Formal *formal : cast<Formals>(node)->formals) {
+                    count += countNodes(formal);
+                }
+                return count;
+            }
+            case NodeKind::FuncDecl: {
+                auto func = cast<FuncDecl>(node);
+                return 1 + countNodes(func->id) + countNodes(func->return_type) + countNodes(func->formals) +
+                       countNodes(func->body);
+            }
+            case NodeKind::Funcs: {
+                size_t count = 1;
+                for (FuncDecl *func : cast<Funcs>(node)->funcs) {
+                    count += countNodes(func);
+                }
+                return count;
+            }
+            default:
+                return 1;
+        }
+    }
+}
@@ -1,10 +1,16 @@
 #ifndef NODES_HPP
 #define NODES_HPP
 
-#include <memory>
+#include <cassert>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include "visitor.hpp"
+#include "interner.hpp"
+
+struct SymbolEntry;
+struct FunctionSymbolEntry;
 
 namespace ast {
 
@@ -35,27 +41,102 @@ namespace ast {
         STRING
     };
 
-    /* Base class for all AST nodes */
+    /* Kinds of the concrete AST nodes.
+     * Expressions come first and statements right after them. Call is both, so it sits on the boundary and
+     * each group is a contiguous range of kinds.
+     */
+    enum class NodeKind : unsigned char {
+        Num,
+        NumB,
+        String,
+        Bool,
+        ID,
+        BinOp,
+        RelOp,
+        Not,
+        And,
+        Or,
+        Cast,
+        Call,
+        Statements,
+        Break,
+        Continue,
+        Return,
+        If,
+        While,
+        VarDecl,
+        Assign,
+        Type,
+        ExpList,
+        Formal,
+        Formals,
+        FuncDecl,
+        Funcs,
+
+        FirstExp = Num,
+        LastExp = Call,
+        FirstStatement = Call,
+        LastStatement = Assign
+    };
+
+    class Exp;
+    class Statement;
+
+    /* Base class for all AST nodes.
+     * Nodes are allocated in an Arena (see arena.hpp) that owns the whole tree, so they refer to each other with
+     * plain pointers.
+     */
     class Node {
     public:
-        // Line number in the source code
+        // Line number in the source code, stamped by the ParseContext that built the node
         int line;
+        // Kind of the concrete node, used by isa / cast / dyn_cast instead of RTTI
+        const NodeKind kind;
+
+        // Nodes are built by the parser through ParseContext::make, which sets their line
+        explicit Node(NodeKind kind);
 
-        // Use this constructor only while parsing in bison or flex
-        Node();
+        // Nodes are owned and destroyed by their Arena
+        virtual ~Node() = default;
 
         // Accept method for visitor pattern
         virtual void accept(Visitor &visitor) = 0;
+
+        // Exp and Statement are virtual bases, so a Node can only be turned into them through these.
+        // Prefer cast<Exp> / cast<Statement>, which check the kind first
+        virtual Exp *asExp() { return nullptr; }
+
+        virtual Statement *asStatement() { return nullptr; }
     };
 
     /* Base class for all expressions */
     class Exp : virtual public Node {
     public:
-        Exp() = default;
+        // Type of the expression, inferred once by the semantic analysis. Valid only if `typed` is set
+        BuiltInType type = VOID;
+        bool typed = false;
+
+        // Node is a virtual base, so it is initialized by the concrete node and not here
+        Exp() {}
+
+        Exp *asExp() override { return this; }
+
+        static bool classof(const Node *node) {
+            return node->kind >= NodeKind::FirstExp && node->kind <= NodeKind::LastExp;
+        }
     };
 
     /* Base class for all statements */
     class Statement : virtual public Node {
+    public:
+        // Node is a virtual base, so it is initialized by the concrete node and not here
+        Statement() {}
+
+        Statement *asStatement() override { return this; }
+
+        static bool classof(const Node *node) {
+            return node->kind >= NodeKind::FirstStatement && node->kind <= NodeKind::LastStatement;
+        }
     };
 
     /* Number literal */
@@ -64,8 +145,18 @@ namespace ast {
         // Value of the number
         int value;
 
-        // Constructor that receives a C-style string that represents the number
-        explicit Num(const char *str);
+        // Constructor that receives the text of the number
+        explicit Num(std::string_view text);
+
+        // Constructor that receives the value of the number
+        explicit Num(int value);
+
+        // Whether the number in the text fits an int. The scanner reports the literals that do not as lexical errors
+        static bool fits(std::string_view text);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Num;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -78,8 +169,15 @@ namespace ast {
         // Value of the number
         int value;
 
-        // Constructor that receives a C-style (including b character) string that represents the number
-        explicit NumB(const char *str);
+        // Constructor that receives the text of the number, including the b character
+        explicit NumB(std::string_view text);
+
+        // Constructor that receives the value of the number
+        explicit NumB(int value);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::NumB;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -89,11 +187,15 @@ namespace ast {
     /* String literal */
     class String : public Exp {
     public:
-        // Value of the string
-        std::string value;
+        // Value of the string, a view into the source buffer the program was parsed from
+        std::string_view value;
 
-        // Constructor that receives a C-style string that represents the string *including quotes*
-        explicit String(const char *str);
+        // Constructor that receives the text of the string *including quotes*
+        explicit String(std::string_view text);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::String;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -109,6 +211,10 @@ namespace ast {
         // Constructor that receives the boolean value
         explicit Bool(bool value);
 
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Bool;
+        }
+
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
         }
@@ -117,11 +223,24 @@ namespace ast {
     /* Identifier */
     class ID : public Exp {
     public:
-        // Name of the identifier
-        std::string value;
-
-        // Constructor that receives a C-style string that represents the identifier
-        explicit ID(const char *str);
+        // Interned name of the identifier
+        Symbol name;
+        // Whether the name was already resolved by the semantic analysis
+        bool bound;
+        // Variable the identifier refers to. nullptr if it is unresolved or not a variable
+        const SymbolEntry *variable;
+        // Function the identifier refers to. nullptr if it is unresolved or not a function
+        const FunctionSymbolEntry *function;
+
+        // Constructor that receives the interned name of the identifier
+        explicit ID(Symbol name);
+
+        // Returns the name of the identifier as a string
+        const std::string &text() const;
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::ID;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -132,14 +251,18 @@ namespace ast {
     class BinOp : public Exp {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
         // Operation
         BinOpType op;
 
         // Constructor that receives the left and right operands and the operation
-        BinOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, BinOpType op);
+        BinOp(Exp *left, Exp *right, BinOpType op);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::BinOp;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -150,14 +273,18 @@ namespace ast {
     class RelOp : public Exp {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
         // Operation
         RelOpType op;
 
         // Constructor that receives the left and right operands and the operation
-        RelOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, RelOpType op);
+        RelOp(Exp *left, Exp *right, RelOpType op);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::RelOp;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -168,10 +295,14 @@ namespace ast {
     class Not : public Exp {
     public:
         // Operand
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the operand
-        explicit Not(std::shared_ptr<Exp> exp);
+        explicit Not(Exp *exp);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Not;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -182,12 +313,16 @@ namespace ast {
     class And : public Exp {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
 
         // Constructor that receives the left and right operands
-        And(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right);
+        And(Exp *left, Exp *right);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::And;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -198,12 +333,16 @@ namespace ast {
     class Or : public Exp {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
 
         // Constructor that receives the left and right operands
-        Or(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right);
+        Or(Exp *left, Exp *right);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Or;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -219,6 +358,10 @@ namespace ast {
         // Constructor that receives the type
         explicit Type(BuiltInType type);
 
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Type;
+        }
+
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
         }
@@ -228,12 +371,16 @@ namespace ast {
     class Cast : public Exp {
     public:
         // Expression to be cast
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
         // Target type
-        std::shared_ptr<Type> target_type;
+        Type *target_type;
 
         // Constructor that receives the expression and the target type
-        Cast(std::shared_ptr<Exp> exp, std::shared_ptr<Type> type);
+        Cast(Exp *exp, Type *type);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Cast;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -244,19 +391,23 @@ namespace ast {
     class ExpList : public Node {
     public:
         // List of expressions
-        std::vector<std::shared_ptr<Exp>> exps;
+        std::vector<Exp *> exps;
 
         // Constructor that receives no expressions
-        ExpList() = default;
+        ExpList();
 
         // Constructor that receives the first expression
-        explicit ExpList(std::shared_ptr<Exp> exp);
+        explicit ExpList(Exp *exp);
 
         // Method to add an expression at the beginning of the list
-        void push_front(const std::shared_ptr<Exp> &exp);
+        void push_front(Exp *exp);
 
         // Method to add an expression at the end of the list
-        void push_back(const std::shared_ptr<Exp> &exp);
+        void push_back(Exp *exp);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::ExpList;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -267,15 +418,16 @@ namespace ast {
     class Call : public Exp, public Statement {
     public:
         // Function identifier
-        std::shared_ptr<ID> func_id;
+        ID *func_id;
         // List of arguments as expressions
-        std::shared_ptr<ExpList> args;
+        ExpList *args;
 
-        // Constructor that receives the function identifier and the list of arguments
-        Call(std::shared_ptr<ID> func_id, std::shared_ptr<ExpList> args);
+        // Constructor that receives the function identifier and the list of arguments (empty for parameterless calls)
+        Call(ID *func_id, ExpList *args);
 
-        // Constructor that receives only the function identifier (for parameterless functions)
-        explicit Call(std::shared_ptr<ID> func_id);
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Call;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -286,19 +438,23 @@ namespace ast {
     class Statements : public Statement {
     public:
         // List of statements
-        std::vector<std::shared_ptr<Statement>> statements;
+        std::vector<Statement *> statements;
 
         // Constructor that receives no statements
-        Statements() = default;
+        Statements();
 
         // Constructor that receives the first statement
-        explicit Statements(std::shared_ptr<Statement> statement);
+        explicit Statements(Statement *statement);
 
         // Method to add a statement at the beginning of the list
-        void push_front(const std::shared_ptr<Statement> &statement);
+        void push_front(Statement *statement);
 
         // Method to add a statement at the end of the list
-        void push_back(const std::shared_ptr<Statement> &statement);
+        void push_back(Statement *statement);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Statements;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -307,6 +463,13 @@ namespace ast {
 
     /* Break statement */
     class Break : public Statement {
+    public:
+        Break();
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Break;
+        }
+
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
         }
@@ -314,6 +477,13 @@ namespace ast {
 
     /* Continue statement */
     class Continue : public Statement {
+    public:
+        Continue();
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Continue;
+        }
+
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
         }
@@ -323,10 +493,14 @@ namespace ast {
     class Return : public Statement {
     public:
         // Expression to be returned. If the return is expressionless, this field is nullptr
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the expression to be returned
-        explicit Return(std::shared_ptr<Exp> exp = nullptr);
+        explicit Return(Exp *exp = nullptr);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Return;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -337,15 +511,19 @@ namespace ast {
     class If : public Statement {
     public:
         // Condition expression
-        std::shared_ptr<Exp> condition;
+        Exp *condition;
         // Statement to be executed if the condition is true
-        std::shared_ptr<Statement> then;
+        Statement *then;
         // Statement to be executed if the condition is false. For an if statement without else, this field is nullptr
-        std::shared_ptr<Statement> otherwise;
+        Statement *otherwise;
 
         // Constructor that receives the condition, the statement to be executed if the condition is true, and the statement to be executed if the condition is false
-        If(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> then,
-           std::shared_ptr<Statement> otherwise = nullptr);
+        If(Exp *condition, Statement *then,
+           Statement *otherwise = nullptr);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::If;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -356,12 +534,16 @@ namespace ast {
     class While : public Statement {
     public:
         // Condition expression
-        std::shared_ptr<Exp> condition;
+        Exp *condition;
         // Statement to be executed while the condition is true
-        std::shared_ptr<Statement> body;
+        Statement *body;
 
         // Constructor that receives the condition and the statement to be executed while the condition is true
-        While(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> body);
+        While(Exp *condition, Statement *body);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::While;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -372,14 +554,18 @@ namespace ast {
     class VarDecl : public Statement {
     public:
         // Identifier of the variable
-        std::shared_ptr<ID> id;
+        ID *id;
         // Type of the variable
-        std::shared_ptr<Type> type;
+        Type *type;
         // Initial value of the variable. If the variable is not initialized, this field is nullptr
-        std::shared_ptr<Exp> init_exp;
+        Exp *init_exp;
 
         // Constructor that receives the identifier, the type, and the initial value expression
-        VarDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> type, std::shared_ptr<Exp> init_exp = nullptr);
+        VarDecl(ID *id, Type *type, Exp *init_exp = nullptr);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::VarDecl;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -390,12 +576,16 @@ namespace ast {
     class Assign : public Statement {
     public:
         // Identifier of the variable
-        std::shared_ptr<ID> id;
+        ID *id;
         // Expression to be assigned
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the identifier and the expression to be assigned
-        Assign(std::shared_ptr<ID> id, std::shared_ptr<Exp> exp);
+        Assign(ID *id, Exp *exp);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Assign;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -406,12 +596,16 @@ namespace ast {
     class Formal : public Node {
     public:
         // Identifier of the parameter
-        std::shared_ptr<ID> id;
+        ID *id;
         // Type of the parameter
-        std::shared_ptr<Type> type;
+        Type *type;
 
         // Constructor that receives the identifier and the type
-        Formal(std::shared_ptr<ID> id, std::shared_ptr<Type> type);
+        Formal(ID *id, Type *type);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Formal;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -422,19 +616,23 @@ namespace ast {
     class Formals : public Node {
     public:
         // List of formal parameters
-        std::vector<std::shared_ptr<Formal>> formals;
+        std::vector<Formal *> formals;
 
         // Constructor that receives no parameters
-        Formals() = default;
+        Formals();
 
         // Constructor that receives the first formal parameter
-        explicit Formals(std::shared_ptr<Formal> formal);
+        explicit Formals(Formal *formal);
 
         // Method to add a formal parameter at the beginning of the list
-        void push_front(const std::shared_ptr<Formal> &formal);
+        void push_front(Formal *formal);
 
         // Method to add a formal parameter at the end of the list
-        void push_back(const std::shared_ptr<Formal> &formal);
+        void push_back(Formal *formal);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Formals;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -445,17 +643,21 @@ namespace ast {
     class FuncDecl : public Node {
     public:
         // Identifier of the function
-        std::shared_ptr<ID> id;
+        ID *id;
         // Return type of the function
-        std::shared_ptr<Type> return_type;
+        Type *return_type;
         // List of formal parameters
-        std::shared_ptr<Formals> formals;
+        Formals *formals;
         // Body of the function
-        std::shared_ptr<Statements> body;
+        Statements *body;
 
         // Constructor that receives the identifier, the return type, the list of formal parameters, and the body
-        FuncDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> return_type, std::shared_ptr<Formals> formals,
-                 std::shared_ptr<Statements> body);
+        FuncDecl(ID *id, Type *return_type, Formals *formals,
+                 Statements *body);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::FuncDecl;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -466,26 +668,60 @@ namespace ast {
     class Funcs : public Node {
     public:
         // List of function declarations
-        std::vector<std::shared_ptr<FuncDecl>> funcs;
+        std::vector<FuncDecl *> funcs;
 
         // Constructor that receives no function declarations
-        Funcs() = default;
+        Funcs();
 
         // Constructor that receives the first function declaration
-        explicit Funcs(std::shared_ptr<FuncDecl> func);
+        explicit Funcs(FuncDecl *func);
 
         // Method to add a function declaration at the beginning of the list
-        void push_front(const std::shared_ptr<FuncDecl> &func);
+        void push_front(FuncDecl *func);
 
         // Method to add a function declaration at the end of the list
-        void push_back(const std::shared_ptr<FuncDecl> &func);
+        void push_back(FuncDecl *func);
+
+        static bool classof(const Node *node) {
+            return node->kind == NodeKind::Funcs;
+        }
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
         }
     };
-}
 
-#define YYSTYPE std::shared_ptr<ast::Node>
+    /* Kind-based type checks and casts, used instead of typeid / dynamic_cast */
+
+    // Returns whether the node is a To
+    template <typename To>
+    bool isa(const Node *node) {
+        return To::classof(node);
+    }
+
+    // Casts the node to a To. The node must be a To
+    template <typename To, typename From>
+    To *cast(From *node) {
+        assert(isa<To>(node));
+        if constexpr (!std::is_same<From, Node>::value || std::is_same<To, Node>::value) {
+            return static_cast<To *>(node);
+        } else if constexpr (std::is_base_of<Exp, To>::value) {
+            return static_cast<To *>(node->asExp());
+        } else if constexpr (std::is_base_of<Statement, To>::value) {
+            return static_cast<To *>(node->asStatement());
+        } else {
+            return static_cast<To *>(node);
+        }
+    }
+
+    // Casts the node to a To, or returns nullptr if it is not a To
+    template <typename To, typename From>
+    To *dyn_cast(From *node) {
+        return isa<To>(node) ? cast<To>(node) : nullptr;
+    }
+
+    // Number of nodes of the tree rooted at the node, the node included
+    size_t countNodes(Node *node);
+}
 
 #endif //NODES_HPP
@@ -1,5 +1,7 @@
 #include "output.hpp"
+#include <charconv>
 #include <iostream>
+#include <string_view>
 
 namespace output {
     /* Helper functions */
@@ -24,121 +26,183 @@ namespace output {
     /* Error handling functions */
 
     void errorLex(int lineno) {
-        std::cout << "line " << lineno << ": lexical error\n";
-        exit(0);
+        diagnostics().report({DiagnosticKind::Lex, lineno});
     }
 
     void errorSyn(int lineno) {
-        std::cout << "line " << lineno << ": syntax error\n";
-        exit(0);
+        diagnostics().report({DiagnosticKind::Syn, lineno});
     }
 
     void errorUndef(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " variable " << id << " is not defined" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::Undef, lineno, id});
     }
 
     void errorDefAsFunc(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " symbol " << id << " is a function" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::DefAsFunc, lineno, id});
     }
 
     void errorDefAsVar(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " symbol " << id << " is a variable" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::DefAsVar, lineno, id});
     }
 
     void errorDef(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " symbol " << id << " is already defined" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::Def, lineno, id});
     }
 
     void errorUndefFunc(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " function " << id << " is not defined" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::UndefFunc, lineno, id});
     }
 
     void errorMismatch(int lineno) {
-        std::cout << "line " << lineno << ":" << " type mismatch" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::Mismatch, lineno});
     }
 
     void errorPrototypeMismatch(int lineno, const std::string &id, std::vector<std::string> &paramTypes) {
-        std::cout << "line " << lineno << ": prototype mismatch, function " << id << " expects parameters (";
-
-        for (int i = 0; i < paramTypes.size(); ++i) {
-            std::cout << paramTypes[i];
-            if (i != paramTypes.size() - 1)
-                std::cout << ",";
-        }
-
-        std::cout << ")" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::PrototypeMismatch, lineno, id, paramTypes});
     }
 
     void errorUnexpectedBreak(int lineno) {
-        std::cout << "line " << lineno << ":" << " unexpected break statement" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::UnexpectedBreak, lineno});
     }
 
     void errorUnexpectedContinue(int lineno) {
-        std::cout << "line " << lineno << ":" << " unexpected continue statement" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::UnexpectedContinue, lineno});
     }
 
     void errorMainMissing() {
-        std::cout << "Program has no 'void main()' function" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::MainMissing, 0});
     }
 
     void errorByteTooLarge(int lineno, const int value) {
-        std::cout << "line " << lineno << ": byte value " << value << " out of range" << std::endl;
-        exit(0);
+        diagnostics().report({DiagnosticKind::ByteTooLarge, lineno, {}, {}, value});
     }
 
     /* ScopePrinter class */
 
-    ScopePrinter::ScopePrinter() : indentLevel(0) {}
+    // Names of the types, without building a std::string for each one
+    static std::string_view typeName(ast::BuiltInType type) {
+        switch (type) {
+            case ast::BuiltInType::INT:
+                return "int";
+            case ast::BuiltInType::BOOL:
+                return "bool";
+            case ast::BuiltInType::BYTE:
+                return "byte";
+            case ast::BuiltInType::VOID:
+                return "void";
+            case ast::BuiltInType::STRING:
+                return "string";
+            default:
+                return "unknown";
+        }
+    }
+
+    // Indentation table: the indentation of level i is the first 2 * i characters
+    static const std::string INDENT_TABLE(2 * 64, ' ');
 
-    std::string ScopePrinter::indent() const {
-        std::string result;
-        for (int i = 0; i < indentLevel; ++i) {
-            result += "  ";
+    // Capacity the buffer starts with, so small programs never grow it
+    static const size_t INITIAL_CAPACITY = 64 * 1024;
+
+    // Buffer of the last printer destroyed on this thread, taken over by the next one
+    static thread_local std::string spare_buffer;
+
+    ScopePrinter::ScopePrinter(bool enabled) : indentLevel(0), enabled(enabled) {
+        if (enabled) {
+            buffer = std::move(spare_buffer);
+            buffer.clear();
+            buffer.reserve(INITIAL_CAPACITY);
+        }
+    }
+
+    ScopePrinter::~ScopePrinter() {
+        if (buffer.capacity() > spare_buffer.capacity()) {
+            spare_buffer = std::move(buffer);
         }
-        return result;
+    }
+
+    void ScopePrinter::indent() {
+        size_t width = 2 * indentLevel;
+        while (width > INDENT_TABLE.size()) {
+            buffer += INDENT_TABLE;
+            width -= INDENT_TABLE.size();
+        }
+        buffer.append(INDENT_TABLE, 0, width);
     }
 
     void ScopePrinter::beginScope() {
         indentLevel++;
-        buffer << indent() << "---begin scope---" << std::endl;
+        if (!enabled) {
+            return;
+        }
+        indent();
+        buffer += "---begin scope---\n";
     }
 
     void ScopePrinter::endScope() {
-        buffer << indent() << "---end scope---" << std::endl;
+        if (enabled) {
+            indent();
+            buffer += "---end scope---\n";
+        }
         indentLevel--;
     }
 
     void ScopePrinter::emitVar(const std::string &id, const ast::BuiltInType &type, int offset) {
-        buffer << indent() << id << " " << toString(type) << " " << offset << std::endl;
+        if (!enabled) {
+            return;
+        }
+        char digits[16];
+        char *digits_end = std::to_chars(digits, digits + sizeof(digits), offset).ptr;
+
+        indent();
+        buffer += id;
+        buffer += ' ';
+        buffer += typeName(type);
+        buffer += ' ';
+        buffer.append(digits, digits_end);
+        buffer += '\n';
     }
 
     void ScopePrinter::emitFunc(const std::string &id, const ast::BuiltInType &returnType,
                                 const std::vector<ast::BuiltInType> &paramTypes) {
-        globalsBuffer << id << " " << "(";
+        if (!enabled) {
+            return;
+        }
+        globalsBuffer += id;
+        globalsBuffer += " (";
 
-        for (int i = 0; i < paramTypes.size(); ++i) {
-            globalsBuffer << toString(paramTypes[i]);
+        for (size_t i = 0; i < paramTypes.size(); ++i) {
+            globalsBuffer += typeName(paramTypes[i]);
             if (i != paramTypes.size() - 1)
-                globalsBuffer << ",";
+                globalsBuffer += ',';
+        }
+
+        globalsBuffer += ") -> ";
+        globalsBuffer += typeName(returnType);
+        globalsBuffer += '\n';
+    }
+
+    const std::string &ScopePrinter::body() const {
+        return buffer;
+    }
+
+    void ScopePrinter::appendBody(const std::string &body) {
+        if (enabled) {
+            buffer += body;
         }
+    }
 
-        globalsBuffer << ")" << " -> " << toString(returnType) << std::endl;
+    MemoryUsage ScopePrinter::memoryUsage() const {
+        MemoryUsage usage;
+        usage.objects = 2;
+        usage.live_bytes = globalsBuffer.size() + buffer.size();
+        usage.peak_bytes = globalsBuffer.capacity() + buffer.capacity();
+        return usage;
     }
 
     std::ostream &operator<<(std::ostream &os, const ScopePrinter &printer) {
-        os << "---begin global scope---" << std::endl;
-        os << printer.globalsBuffer.str();
-        os << printer.buffer.str();
+        os << "---begin global scope---\n";
+        os.write(printer.globalsBuffer.data(), printer.globalsBuffer.size());
+        os.write(printer.buffer.data(), printer.buffer.size());
         os << "---end global scope---" << std::endl;
         return os;
     }
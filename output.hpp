@@ -1,17 +1,22 @@
 #ifndef OUTPUT_HPP
 #define OUTPUT_HPP
 
+#include <ostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include "visitor.hpp"
 #include "nodes.hpp"
+#include "diagnostics.hpp"
+#include "mem_report.hpp"
 
 namespace output {
 
     std::string toString(ast::BuiltInType type);
 
-    /* Error handling functions */
+    /* Error handling functions
+     * Every error is reported to the Diagnostics engine of the calling thread (see diagnostics.hpp). They return only
+     * if the engine collects all the errors, otherwise they throw CompilationError.
+     */
 
     void errorLex(int lineno);
 
@@ -41,17 +46,28 @@ namespace output {
 
     /* ScopePrinter class
      * This class is used to print scopes in a human-readable format.
+     * The scope bodies are appended to one large buffer as the analysis runs; only the globals section, which is
+     * printed first, is held back. The buffer is handed over to the next printer of the same thread, so repeated
+     * compilations reuse its memory. A disabled printer builds no output at all.
      */
     class ScopePrinter {
     private:
-        std::stringstream globalsBuffer;
-        std::stringstream buffer;
+        std::string globalsBuffer;
+        std::string buffer;
         int indentLevel;
+        bool enabled;
 
-        std::string indent() const;
+        // Appends the indentation of the current level to the buffer
+        void indent();
 
     public:
-        ScopePrinter();
+        explicit ScopePrinter(bool enabled = true);
+
+        ~ScopePrinter();
+
+        ScopePrinter(const ScopePrinter &) = delete;
+
+        ScopePrinter &operator=(const ScopePrinter &) = delete;
 
         void beginScope();
 
@@ -62,6 +78,15 @@ namespace output {
         void emitFunc(const std::string &id, const ast::BuiltInType &returnType,
                       const std::vector<ast::BuiltInType> &paramTypes);
 
+        // Scope output printed so far, without the globals section
+        const std::string &body() const;
+
+        // Appends scope output of another printer, produced at the same nesting level
+        void appendBody(const std::string &body);
+
+        // The output buffers, as one object each
+        MemoryUsage memoryUsage() const;
+
         friend std::ostream &operator<<(std::ostream &os, const ScopePrinter &printer);
     };
 }
@@ -0,0 +1,64 @@
+#ifndef PARSE_CONTEXT_HPP
+#define PARSE_CONTEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "nodes.hpp"
+#include "arena.hpp"
+#include "source_buffer.hpp"
+#include "time_report.hpp"
+
+// Handle of a reentrant flex scanner, as declared by the generated scanner
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+int yyget_lineno(yyscan_t scanner);
+
+namespace ast {
+
+    /* ParseContext class
+     * State of a single parse, shared by the reentrant scanner and the pure parser instead of globals.
+     * Each compilation owns its own context, so several parses can run at the same time.
+     */
+    class ParseContext {
+    public:
+        // Owner of every node built by this parse
+        Arena &arena;
+        // Scanner of this parse, set once the scanner is initialized
+        yyscan_t scanner;
+        // Root of the AST, set by the parser when it reduces the start variable
+        Node *program;
+        // Report the time spent in the scanner goes to, or nullptr if it is not timed
+        TimeReport *time_report;
+        uint64_t lex_ns;
+
+        explicit ParseContext(Arena &arena, TimeReport *time_report = nullptr)
+                : arena(arena), scanner(nullptr), program(nullptr), time_report(time_report), lex_ns(0) {}
+
+        ~ParseContext() {
+            if (time_report) {
+                time_report->add("lex", lex_ns);
+            }
+        }
+
+        // Allocates a node in the arena and stamps it with the current line of the scanner
+        template <typename T, typename... Args>
+        T *make(Args &&... args) {
+            T *node = arena.make<T>(std::forward<Args>(args)...);
+            node->line = yyget_lineno(scanner);
+            return node;
+        }
+    };
+
+    // Parses the given source and returns the root of its AST, allocated in the given arena. The source is scanned
+    // in place and the AST keeps views into it. With a report, the time spent in the scanner is added to it
+    Node *parse(SourceBuffer &source, Arena &arena, TimeReport *time_report = nullptr);
+
+    // Runs the scanner alone over the source and returns the number of tokens. The literal nodes go to the arena
+    size_t scanTokens(SourceBuffer &source, Arena &arena);
+}
+
+#endif //PARSE_CONTEXT_HPP
@@ -1,28 +1,41 @@
-%{
+%code requires {
+#include "parse_context.hpp"
+}
 
-#include "nodes.hpp"
-#include "output.hpp"
+%code provides {
+// The reentrant scanner, generated by flex with bison-bridge
+int yylex(YYSTYPE *yylval, yyscan_t scanner);
+}
 
-// bison declarations
-extern int yylineno;
-extern int yylex();
+%code {
 
-void yyerror(const char*);
+#include "output.hpp"
 
-// root of the AST, set by the parser and used by other parts of the compiler
-std::shared_ptr<ast::Node> program;
+void yyerror(yyscan_t scanner, ast::ParseContext &context, const char *message);
 
 using namespace std;
 
-%}
+}
+
+// A pure parser: all of its state is local to yyparse, and the scanner and the context are passed in
+%define api.pure full
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner} {ast::ParseContext &context}
+
+// Semantic values. Operators carry only their kind, every other token and rule carries a node
+%union {
+    ast::Node *node;
+    ast::RelOpType rel_op;
+    ast::BinOpType bin_op;
+}
 
 %token INT BYTE BOOL VOID
 %token TRUE FALSE
 %token IF WHILE BREAK CONTINUE
 
-%token ID
-%token NUM NUM_B
-%token STRING
+%token <node> ID
+%token <node> NUM NUM_B
+%token <node> STRING
 %token RETURN
 
 %token SC COMMA ASSIGN
@@ -33,48 +46,50 @@ using namespace std;
 %left OR
 %left AND
 //adding difference between the different RELOP 
-%left RELOP
-%left LEFTOP
-%left RIGHTOP
+%left <rel_op> RELOP
+%left <bin_op> LEFTOP
+%left <bin_op> RIGHTOP
 %right NOT
 %left LPAREN RPAREN LBRACE RBRACE LBRACK RBRACK
 
 //to handle the dangling-else problem
 %right ELSE
 
+%type <node> Funcs FuncDecl RetType Formals FormalsList FormalDecl Statements Statement Call ExpList Type Exp
+
 %%
 
 // While reducing the start variable, set the root of the AST
-Program:  Funcs { program = $1; }
+Program:  Funcs { context.program = $1; }
 ;
 
-Funcs: FuncDecl Funcs{$$= std::dynamic_pointer_cast<ast::Funcs>($2);
-                        std::dynamic_pointer_cast<ast::Funcs>($$)->push_front(std::dynamic_pointer_cast<ast::FuncDecl>($1));}
-        | {$$ = std::make_shared<ast::Funcs>();}
+Funcs: FuncDecl Funcs{$$= ast::cast<ast::Funcs>($2);
+                        ast::cast<ast::Funcs>($$)->push_front(ast::cast<ast::FuncDecl>($1));}
+        | {$$ = context.make<ast::Funcs>();}
 
-FuncDecl: RetType ID LPAREN Formals RPAREN LBRACE Statements RBRACE{$$=std::make_shared<ast::FuncDecl>(
-    std::dynamic_pointer_cast<ast::ID>($2), 
-    std::dynamic_pointer_cast<ast::Type>($1),
-    std::dynamic_pointer_cast<ast::Formals>($4),
-    std::dynamic_pointer_cast<ast::Statements>($7)
+FuncDecl: RetType ID LPAREN Formals RPAREN LBRACE Statements RBRACE{$$=context.make<ast::FuncDecl>(
+    ast::cast<ast::ID>($2), 
+    ast::cast<ast::Type>($1),
+    ast::cast<ast::Formals>($4),
+    ast::cast<ast::Statements>($7)
     );};
 
 RetType: Type {$$ = $1;}
-    | VOID { $$ = std::make_shared<ast::Type>(ast::BuiltInType::VOID); }
+    | VOID { $$ = context.make<ast::Type>(ast::BuiltInType::VOID); }
 
 Formals:  FormalsList {$$ = $1;}
-            | {$$ = std::make_shared<ast::Formals>();}
+            | {$$ = context.make<ast::Formals>();}
 
-FormalsList: FormalDecl {$$ = std::make_shared<ast::Formals>(std::dynamic_pointer_cast<ast::Formal>($1));}
-            | FormalsList COMMA FormalDecl {auto formals = std::dynamic_pointer_cast<ast::Formals>($1);
-                                            formals->push_back(std::dynamic_pointer_cast<ast::Formal>($3));
+FormalsList: FormalDecl {$$ = context.make<ast::Formals>(ast::cast<ast::Formal>($1));}
+            | FormalsList COMMA FormalDecl {auto formals = ast::cast<ast::Formals>($1);
+                                            formals->push_back(ast::cast<ast::Formal>($3));
                                             $$ = formals;}
 
-FormalDecl: Type ID {$$ = std::make_shared<ast::Formal>(std::dynamic_pointer_cast<ast::ID>($2), std::dynamic_pointer_cast<ast::Type>($1));}
+FormalDecl: Type ID {$$ = context.make<ast::Formal>(ast::cast<ast::ID>($2), ast::cast<ast::Type>($1));}
  
 Statements: Statements Statement {
-                auto statements = std::dynamic_pointer_cast<ast::Statements>($1);
-                statements->push_back(std::dynamic_pointer_cast<ast::Statement>($2));
+                auto statements = ast::cast<ast::Statements>($1);
+                statements->push_back(ast::cast<ast::Statement>($2));
                 $$ = statements;
                 if(!$1)
                 {
@@ -85,56 +100,55 @@ Statements: Statements Statement {
                     printf("$s2");
                 }
             }
-            | Statement {$$=std::make_shared<ast::Statements>(std::dynamic_pointer_cast<ast::Statement>($1));}
+            | Statement {$$=context.make<ast::Statements>(ast::cast<ast::Statement>($1));}
 
 
-Statement: LBRACE Statements RBRACE {$$=std::dynamic_pointer_cast<ast::Statement>($2);}
-    | Type ID SC {$$=std::make_shared<ast::VarDecl>(std::dynamic_pointer_cast<ast::ID>($2), std::dynamic_pointer_cast<ast::Type>($1));}
-    | Type ID ASSIGN Exp SC {$$=std::make_shared<ast::VarDecl>(std::dynamic_pointer_cast<ast::ID>($2), std::dynamic_pointer_cast<ast::Type>($1),std::dynamic_pointer_cast<ast::Exp>($4));}
-    | ID ASSIGN Exp SC {$$=std::make_shared<ast::Assign>(std::dynamic_pointer_cast<ast::ID>($1), std::dynamic_pointer_cast<ast::Exp>($3));}
+Statement: LBRACE Statements RBRACE {$$=ast::cast<ast::Statement>($2);}
+    | Type ID SC {$$=context.make<ast::VarDecl>(ast::cast<ast::ID>($2), ast::cast<ast::Type>($1));}
+    | Type ID ASSIGN Exp SC {$$=context.make<ast::VarDecl>(ast::cast<ast::ID>($2), ast::cast<ast::Type>($1),ast::cast<ast::Exp>($4));}
+    | ID ASSIGN Exp SC {$$=context.make<ast::Assign>(ast::cast<ast::ID>($1), ast::cast<ast::Exp>($3));}
     | Call SC {$$ = $1;}
-    | RETURN SC {$$ = std::make_shared<ast::Return>();}
-    | RETURN Exp SC {$$ = std::make_shared<ast::Return>(std::dynamic_pointer_cast<ast::Exp>($2));}
-    | IF LPAREN Exp RPAREN Statement {$$ = std::make_shared<ast::If>(std::dynamic_pointer_cast<ast::Exp>($3), std::dynamic_pointer_cast<ast::Statement>($5));}
-    | IF LPAREN Exp RPAREN Statement ELSE Statement {$$ = std::make_shared<ast::If>(std::dynamic_pointer_cast<ast::Exp>($3), 
-                                            std::dynamic_pointer_cast<ast::Statement>($5), std::dynamic_pointer_cast<ast::Statement>($7));}
-    | WHILE LPAREN Exp RPAREN Statement {$$ = std::make_shared<ast::While>(std::dynamic_pointer_cast<ast::Exp>($3),
-                                         std::dynamic_pointer_cast<ast::Statement>($5));}
-    | BREAK SC                  { $$ = std::make_shared<ast::Break>(); }
-    | CONTINUE SC               { $$ = std::make_shared<ast::Continue>(); }
+    | RETURN SC {$$ = context.make<ast::Return>();}
+    | RETURN Exp SC {$$ = context.make<ast::Return>(ast::cast<ast::Exp>($2));}
+    | IF LPAREN Exp RPAREN Statement {$$ = context.make<ast::If>(ast::cast<ast::Exp>($3), ast::cast<ast::Statement>($5));}
+    | IF LPAREN Exp RPAREN Statement ELSE Statement {$$ = context.make<ast::If>(ast::cast<ast::Exp>($3), 
+                                            ast::cast<ast::Statement>($5), ast::cast<ast::Statement>($7));}
+    | WHILE LPAREN Exp RPAREN Statement {$$ = context.make<ast::While>(ast::cast<ast::Exp>($3),
+                                         ast::cast<ast::Statement>($5));}
+    | BREAK SC                  { $$ = context.make<ast::Break>(); }
+    | CONTINUE SC               { $$ = context.make<ast::Continue>(); }
     
 
-Call: ID LPAREN ExpList RPAREN  {$$ = std::make_shared<ast::Call>(std::dynamic_pointer_cast<ast::ID>($1), std::dynamic_pointer_cast<ast::ExpList>($3));}
-    | ID LPAREN RPAREN          { $$ = std::make_shared<ast::Call>(std::dynamic_pointer_cast<ast::ID>($1));}
+Call: ID LPAREN ExpList RPAREN  {$$ = context.make<ast::Call>(ast::cast<ast::ID>($1), ast::cast<ast::ExpList>($3));}
+    | ID LPAREN RPAREN          { $$ = context.make<ast::Call>(ast::cast<ast::ID>($1), context.make<ast::ExpList>());}
 
-ExpList: Exp                     {$$= std::make_shared<ast::ExpList>(std::dynamic_pointer_cast<ast::Exp>($1)); }
-    | Exp COMMA ExpList          { auto explist = std::dynamic_pointer_cast<ast::ExpList>($3); explist->push_front(std::dynamic_pointer_cast<ast::Exp>($1)); $$ = explist;}
+ExpList: Exp                     {$$= context.make<ast::ExpList>(ast::cast<ast::Exp>($1)); }
+    | Exp COMMA ExpList          { auto explist = ast::cast<ast::ExpList>($3); explist->push_front(ast::cast<ast::Exp>($1)); $$ = explist;}
 
-Type: INT   { $$ = std::make_shared<ast::Type>(ast::BuiltInType::INT); }
-    | BYTE  { $$ = std::make_shared<ast::Type>(ast::BuiltInType::BYTE); }
-    | BOOL  { $$ = std::make_shared<ast::Type>(ast::BuiltInType::BOOL); }
+Type: INT   { $$ = context.make<ast::Type>(ast::BuiltInType::INT); }
+    | BYTE  { $$ = context.make<ast::Type>(ast::BuiltInType::BYTE); }
+    | BOOL  { $$ = context.make<ast::Type>(ast::BuiltInType::BOOL); }
 
 Exp: LPAREN Exp RPAREN          { $$ = $2; }
-    | Exp LEFTOP Exp  { $$ = std::make_shared<ast::BinOp>(std::dynamic_pointer_cast<ast::Exp>($1), std::dynamic_pointer_cast<ast::Exp>($3), std::dynamic_pointer_cast<ast::BinOp>($2)->op); }
-    | Exp RIGHTOP Exp { $$ = std::make_shared<ast::BinOp>(std::dynamic_pointer_cast<ast::Exp>($1), std::dynamic_pointer_cast<ast::Exp>($3), std::dynamic_pointer_cast<ast::BinOp>($2)->op); }
+    | Exp LEFTOP Exp  { $$ = context.make<ast::BinOp>(ast::cast<ast::Exp>($1), ast::cast<ast::Exp>($3), $2); }
+    | Exp RIGHTOP Exp { $$ = context.make<ast::BinOp>(ast::cast<ast::Exp>($1), ast::cast<ast::Exp>($3), $2); }
     | ID                         { $$ = $1;}
     | Call                       { $$ = $1; }
     | NUM                        { $$ = $1; }
     | NUM_B                      { $$ = $1; }
     | STRING                     { $$ = $1; }
-    | TRUE                       { $$ = std::make_shared<ast::Bool>(true); }
-    | FALSE                      { $$ = std::make_shared<ast::Bool>(false); }
-    | NOT Exp                    { $$ = std::make_shared<ast::Not>(std::dynamic_pointer_cast<ast::Exp>($2)); }
-    | Exp AND Exp                { $$ = std::make_shared<ast::And>(std::dynamic_pointer_cast<ast::Exp>($1), std::dynamic_pointer_cast<ast::Exp>($3)); }
-    | Exp OR Exp                 { $$ = std::make_shared<ast::Or>(std::dynamic_pointer_cast<ast::Exp>($1), std::dynamic_pointer_cast<ast::Exp>($3)); }
-    | Exp RELOP Exp              { $$ = std::make_shared<ast::RelOp>(std::dynamic_pointer_cast<ast::Exp>($1), std::dynamic_pointer_cast<ast::Exp>($3), std::dynamic_pointer_cast<ast::RelOp>($2)->op); }
-    | LPAREN Type RPAREN Exp     { $$ = std::make_shared<ast::Cast>(std::dynamic_pointer_cast<ast::Exp>($4), std::dynamic_pointer_cast<ast::Type>($2)); }
+    | TRUE                       { $$ = context.make<ast::Bool>(true); }
+    | FALSE                      { $$ = context.make<ast::Bool>(false); }
+    | NOT Exp                    { $$ = context.make<ast::Not>(ast::cast<ast::Exp>($2)); }
+    | Exp AND Exp                { $$ = context.make<ast::And>(ast::cast<ast::Exp>($1), ast::cast<ast::Exp>($3)); }
+    | Exp OR Exp                 { $$ = context.make<ast::Or>(ast::cast<ast::Exp>($1), ast::cast<ast::Exp>($3)); }
+    | Exp RELOP Exp              { $$ = context.make<ast::RelOp>(ast::cast<ast::Exp>($1), ast::cast<ast::Exp>($3), $2); }
+    | LPAREN Type RPAREN Exp     { $$ = context.make<ast::Cast>(ast::cast<ast::Exp>($4), ast::cast<ast::Type>($2)); }
 
 
 
 %%
 
-void yyerror(const char * message){
-	output::errorSyn(yylineno);
-	exit(0);
-}
\ No newline at end of file
+void yyerror(yyscan_t scanner, ast::ParseContext &context, const char *message) {
+	output::errorSyn(yyget_lineno(scanner));
+}
@@ -0,0 +1,166 @@
+#!/bin/bash
+
+# Define color variables for readability
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+# Executable name
+EXEC_NAME="./hw3"
+
+# Sizes (number of declarations) of the generated programs
+SIZES=(2000 4000 8000 16000 32000)
+
+# ================= Compile The code =================
+echo -e "${BLUE}============== Compiling the code! ==============${NC}"
+make
+if [[ $? != 0 ]]; then
+    echo -e "${RED}Cannot build the code!${NC}"
+    exit 1
+fi
+
+echo -e "${GREEN}============== The code compiled successfully ! ==============${NC}"
+
+# Prints the wall time of one run of the compiler on the given input, in nanoseconds
+time_run() {
+    local start end
+    start=$(date +%s%N)
+    $EXEC_NAME < "$1" > /dev/null 2>&1
+    end=$(date +%s%N)
+    echo $((end - start))
+}
+
+# ================= Symbol table scaling =================
+# The cost per declaration should stay flat while the number of symbols grows.
+for shape in symbols_flat symbols_nested; do
+    echo -e "${BLUE}============== ${shape} ==============${NC}"
+    printf "%10s %14s %14s\n" "symbols" "total (ms)" "per decl (ns)"
+    for input in $(python3 create_benchmarks.py "$shape" "${SIZES[@]}"); do
+        size=$(basename "$input" .in)
+        size=${size##*_}
+        elapsed=$(time_run "$input")
+        printf "%10d %14d %14d\n" "$size" $((elapsed / 1000000)) $((elapsed / size))
+    done
+done
+
+# ================= Expression chain scaling =================
+# Each operand of a long a + b * c - ... chain should cost the same, however long the chain is.
+echo -e "${BLUE}============== long_expressions ==============${NC}"
+printf "%10s %14s %14s\n" "operands" "total (ms)" "per op (ns)"
+for input in $(python3 create_benchmarks.py long_expressions "${SIZES[@]}"); do
+    size=$(basename "$input" .in)
+    size=${size##*_}
+    elapsed=$(time_run "$input")
+    printf "%10d %14d %14d\n" "$size" $((elapsed / 1000000)) $((elapsed / size))
+done
+
+# ================= Node type checks =================
+# RTTI against the NodeKind tags, on the checks the parser and the analyzer perform.
+echo -e "${BLUE}============== node_kind_bench ==============${NC}"
+g++ -std=c++17 -O2 -DNDEBUG -o bench/node_kind_bench bench/node_kind_bench.cpp nodes.cpp interner.cpp arena.cpp && ./bench/node_kind_bench
+
+# ================= Parallel function analysis =================
+# One file with many functions, its bodies checked on 1, 2, 4, ... up to nproc threads. The output must not change.
+# Funcs is right-recursive, so the parser stack holds every function: stay below bison's 10000 entries.
+echo -e "${BLUE}============== many_functions ==============${NC}"
+input=$(python3 create_benchmarks.py many_functions 5000)
+expected=$($EXEC_NAME --input "$input" | md5sum)
+printf "%10s %14s %14s\n" "jobs" "total (ms)" "same output"
+jobs=1
+cores=$(nproc)
+while true; do
+    start=$(date +%s%N)
+    actual=$($EXEC_NAME --jobs $jobs --input "$input" | md5sum)
+    end=$(date +%s%N)
+    printf "%10d %14d %14s\n" $jobs $(((end - start) / 1000000)) $([[ "$actual" == "$expected" ]] && echo yes || echo NO)
+    if ((jobs >= cores)); then
+        break
+    fi
+    jobs=$((jobs * 2 > cores ? cores : jobs * 2))
+done
+
+# ================= Batch throughput =================
+# Files per second of a single batch process against the number of worker threads, next to one process per file.
+echo -e "${BLUE}============== batch_throughput ==============${NC}"
+BATCH_FILES=()
+for round in $(seq 1 20); do
+    BATCH_FILES+=(hw3-tests/*.in generated_tests/*.in segel_tests/*.in)
+done
+count=${#BATCH_FILES[@]}
+printf "%10s %14s %14s\n" "jobs" "total (ms)" "files/sec"
+
+start=$(date +%s%N)
+for input in "${BATCH_FILES[@]}"; do
+    $EXEC_NAME < "$input" > /dev/null 2>&1
+done
+end=$(date +%s%N)
+printf "%10s %14d %14d\n" "per-file" $(((end - start) / 1000000)) $((count * 1000000000 / (end - start)))
+
+jobs=1
+cores=$(nproc)
+while true; do
+    start=$(date +%s%N)
+    $EXEC_NAME --jobs $jobs "${BATCH_FILES[@]}" > /dev/null 2>&1
+    end=$(date +%s%N)
+    printf "%10d %14d %14d\n" $jobs $(((end - start) / 1000000)) $((count * 1000000000 / (end - start)))
+    if ((jobs >= cores)); then
+        break
+    fi
+    jobs=$((jobs * 2 > cores ? cores : jobs * 2))
+done
+
+# ================= Function cache =================
+# A cold run fills the cache, a warm run serves every body from it, and after editing one function only that
+# function is analyzed again. The output must be the same as without the cache.
+echo -e "${BLUE}============== function_cache ==============${NC}"
+input=$(python3 create_benchmarks.py many_functions 5000)
+edited="${input%.in}_edited.in"
+sed '0,/s = s - k;/s//s = s - k - 1;/' "$input" > "$edited"
+cache_dir=$(mktemp -d)
+printf "%10s %14s %14s  %s\n" "run" "total (ms)" "same output" "cache"
+for run in cold warm edited; do
+    file=$([[ $run == edited ]] && echo "$edited" || echo "$input")
+    expected=$($EXEC_NAME --input "$file" | md5sum)
+    start=$(date +%s%N)
+    actual=$($EXEC_NAME --cache-dir "$cache_dir" --cache-stats --input "$file" 2> "$cache_dir/stats" | md5sum)
+    end=$(date +%s%N)
+    printf "%10s %14d %14s  %s\n" $run $(((end - start) / 1000000)) $([[ "$actual" == "$expected" ]] && echo yes || echo NO) "$(cat "$cache_dir/stats")"
+done
+rm -rf "$cache_dir"
+
+# ================= Compile server latency =================
+# Latency of one request through client/hw3_client to a warm `hw3 --serve`, next to a fresh hw3 process per
+# request. Every request sends the same program, and the answers must match.
+echo -e "${BLUE}============== server_latency ==============${NC}"
+make client > /dev/null || exit 1
+socket=$(mktemp -u /tmp/hw3-bench-XXXXXX.sock)
+$EXEC_NAME --serve "$socket" &
+server=$!
+while [[ ! -S "$socket" ]]; do sleep 0.05; done
+
+# Prints the median and 99th percentile of the latencies given on stdin, in microseconds
+percentiles() {
+    sort -n | awk '{ v[NR] = $1 } END { printf "%14d %14d", v[int((NR + 1) / 2)] / 1000, v[int(NR * 0.99 + 0.5)] / 1000 }'
+}
+
+REQUESTS=500
+printf "%10s %14s %14s %14s\n" "input" "command" "p50 (us)" "p99 (us)"
+for input in hw3-tests/t1.in $(python3 create_benchmarks.py many_functions 500); do
+    expected=$($EXEC_NAME < "$input" | md5sum)
+    actual=$(./client/hw3_client --socket "$socket" < "$input" | md5sum)
+    if [[ "$actual" != "$expected" ]]; then
+        echo -e "${RED}The server answers differently on ${input}${NC}"
+    fi
+    for command in "$EXEC_NAME" "./client/hw3_client --socket $socket"; do
+        for request in $(seq 1 $REQUESTS); do
+            start=$(date +%s%N)
+            $command < "$input" > /dev/null 2>&1
+            end=$(date +%s%N)
+            echo $((end - start))
+        done | percentiles | xargs printf "%10s %14s %14s %14s\n" "$(basename "$input" .in)" "${command%% *}"
+    done
+done
+
+kill $server
+wait $server 2> /dev/null
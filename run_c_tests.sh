@@ -0,0 +1,116 @@
+#!/bin/bash
+
+# Compiles every success test (a program without errors) to C with --emit-c, builds it with the system C compiler
+# and checks that it prints what the same program prints on the virtual machine (--run).
+# Programs that do not finish on the virtual machine within a few seconds, or that overflow its stack, are skipped.
+
+# Define color variables for readability
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[0;33m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+# Executable name, and the C compiler
+EXEC_NAME="./hw3"
+CC="${CC:-gcc}"
+CFLAGS="-O2 -w"
+
+# Directories
+TEST_DIRS=("./segel_tests/" "./generated_tests/" "./vm_tests/")
+OUTPUT_DIR="./c_tests_results/"
+TIMEOUT=5
+
+# Check for verbose flag
+VERBOSE=0
+if [[ "$1" == "-v" ]]; then
+    VERBOSE=1
+fi
+
+# ================= Compile The code =================
+echo -e "${BLUE}============== Compiling the code! ==============${NC}"
+make
+if [[ $? != 0 ]]; then
+    echo -e "${RED}Cannot build the code!${NC}"
+    exit 1
+fi
+
+echo -e "${GREEN}============== The code compiled successfully ! ==============${NC}"
+
+# ================= Setup Directories =================
+rm -rf ${OUTPUT_DIR}
+mkdir -p ${OUTPUT_DIR}
+
+passed_tests=0
+total_tests=0
+skipped_tests=0
+
+for TESTS_DIR in "${TEST_DIRS[@]}"; do
+    if [ ! -d "$TESTS_DIR" ]; then
+        echo -e "${YELLOW}Directory $TESTS_DIR does not exist. Skipping.${NC}"
+        continue
+    fi
+
+    echo -e "${BLUE}============== Running C Tests from ${TESTS_DIR} ==============${NC}"
+
+    for test_file in ${TESTS_DIR}*.in; do
+        [ -e "$test_file" ] || continue
+
+        filename=$(basename -- "$test_file")
+        test_name="${filename%.*}"
+
+        # Only the programs without errors can be translated
+        $EXEC_NAME --check-only < "$test_file" > /dev/null 2>&1 || continue
+
+        expected_output="${OUTPUT_DIR}${test_name}.vm"
+        actual_output="${OUTPUT_DIR}${test_name}.res"
+        c_file="${OUTPUT_DIR}${test_name}.c"
+        binary="${OUTPUT_DIR}${test_name}"
+
+        timeout $TIMEOUT $EXEC_NAME --run < "$test_file" > "$expected_output" 2>&1
+        if [[ $? != 0 ]] || grep -q "^Error stack overflow$" "$expected_output"; then
+            skipped_tests=$((skipped_tests + 1))
+            continue
+        fi
+        total_tests=$((total_tests + 1))
+
+        $EXEC_NAME --emit-c < "$test_file" > "$c_file" 2>&1
+        if ! $CC $CFLAGS -o "$binary" "$c_file" 2> "${OUTPUT_DIR}${test_name}.cc"; then
+            echo -e "${RED}Failed test: ${test_name}! (the C code does not compile)${NC}"
+            if [ $VERBOSE -eq 1 ]; then
+                cat "${OUTPUT_DIR}${test_name}.cc"
+                echo "------------------------------------------------"
+            fi
+            continue
+        fi
+        timeout $TIMEOUT "$binary" > "$actual_output" 2>&1
+
+        diff_output=$(diff "$expected_output" "$actual_output")
+
+        if [ -n "$diff_output" ]; then
+            echo -e "${RED}Failed test: ${test_name}!${NC}"
+            if [ $VERBOSE -eq 1 ]; then
+                echo "Diff:"
+                diff -u "$expected_output" "$actual_output"
+                echo "------------------------------------------------"
+            fi
+        else
+            echo -e "${GREEN}Test ${test_name} passed!${NC}"
+            passed_tests=$((passed_tests + 1))
+        fi
+    done
+done
+
+# ================= Summary =================
+echo -e "\n${BLUE}============== Summary ==============${NC}"
+if [ $skipped_tests -gt 0 ]; then
+    echo -e "${YELLOW}Skipped $skipped_tests programs that do not finish on the virtual machine.${NC}"
+fi
+if [ $passed_tests -eq $total_tests ] && [ $total_tests -gt 0 ]; then
+    echo -e "${GREEN}All C tests passed! ($passed_tests/$total_tests)${NC}"
+else
+    echo -e "${YELLOW}Passed $passed_tests out of $total_tests C tests.${NC}"
+    if [ $VERBOSE -eq 0 ]; then
+        echo -e "${YELLOW}Tip: Run with './run_c_tests.sh -v' to see the diffs for failed tests.${NC}"
+    fi
+fi
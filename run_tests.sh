@@ -11,7 +11,12 @@ NC='\033[0m' # No Color
 EXEC_NAME="./hw3"
 
 # Directories
-TEST_DIRS=("./generated_tests/" "./hw3-tests/" "./segel_tests/")
+TEST_DIRS=("./generated_tests/" "./hw3-tests/" "./segel_tests/" "./all_errors_tests/" "./fold_tests/" "./dead_code_tests/" "./vm_tests/" "./jit_tests/" "./ir_tests/" "./frame_layout_tests/")
+# Extra command line flags for the tests of a directory
+declare -A TEST_FLAGS=(["./all_errors_tests/"]="--all-errors" ["./fold_tests/"]="--fold-constants"
+                       ["./dead_code_tests/"]="--fold-constants --eliminate-dead-code"
+                       ["./vm_tests/"]="--run" ["./jit_tests/"]="--jit" ["./ir_tests/"]="--dump-ir"
+                       ["./frame_layout_tests/"]="--frame-layout")
 OUTPUT_DIR="./tests_results/"
 
 # Check for verbose flag
@@ -62,7 +67,7 @@ for TESTS_DIR in "${TEST_DIRS[@]}"; do
 
         # Run the test
         # redirecting stderr to stdout (2>&1) as per instructions
-        $EXEC_NAME < "$test_file" > "$actual_output" 2>&1
+        $EXEC_NAME ${TEST_FLAGS[$TESTS_DIR]} < "$test_file" > "$actual_output" 2>&1
 
         # Compare output
         diff_output=$(diff "$expected_output" "$actual_output")
@@ -1,43 +1,75 @@
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 
 #include "semantic_analayzer_visitor.hpp"
-
-SemanticAnalayzerVisitor::SemanticAnalayzerVisitor() : number_of_while_inside(0) {}
+#include "thread_pool.hpp"
+
+SemanticAnalayzerVisitor::SemanticAnalayzerVisitor(bool print_scopes, size_t jobs, FunctionCache *cache,
+                                                   TimeReport *time_report)
+        : scope_printer(print_scopes), current_function(nullptr), number_of_while_inside(0),
+          print_name(StringInterner::global().intern("print")),
+          printi_name(StringInterner::global().intern("printi")),
+          main_name(StringInterner::global().intern("main")),
+          print_scopes(print_scopes), jobs(jobs), cache(cache), time_report(time_report) {}
+
+SemanticAnalayzerVisitor::SemanticAnalayzerVisitor(const SemanticAnalayzerVisitor &parent,
+                                                   const FunctionSymbolEntry *function)
+        : scope_printer(parent.print_scopes), symbol_table(&parent.symbol_table), current_function(function),
+          number_of_while_inside(0), print_name(parent.print_name), printi_name(parent.printi_name),
+          main_name(parent.main_name), print_scopes(parent.print_scopes), jobs(1), cache(nullptr),
+          time_report(parent.time_report) {}
 
 void SemanticAnalayzerVisitor::visit(ast::Funcs &node) {
     // adding global scope offset
     offset_stack.push(0);
 
+    {
+        TimeScope signatures(time_report, "signatures");
+        collectSignatures(node);
+    }
+
+    TimeScope bodies(time_report, "bodies");
+    if (jobs > 1 || cache) {
+        analyzeBodiesSeparately(node);
+        return;
+    }
+
+    for (auto it = node.funcs.begin(); it != node.funcs.end(); ++it) {
+        // correction of 2 because of 'print' and 'printi' functionns 
+        current_function = &symbol_table.function(std::distance(node.funcs.begin(), it) + 2);
+        (*it)->accept(*this);
+    }
+}
+
+void SemanticAnalayzerVisitor::collectSignatures(ast::Funcs &node) {
     // emit library functions
     scope_printer.emitFunc("print", ast::BuiltInType::VOID, {ast::BuiltInType::STRING});
     scope_printer.emitFunc("printi", ast::BuiltInType::VOID, {ast::BuiltInType::INT});
-    FunctionSymbolEntry print_entry = {"print", offset_stack.top()++, ast::BuiltInType::VOID, {ast::BuiltInType::STRING}};
-    FunctionSymbolEntry printi_entry = {"printi", offset_stack.top()++, ast::BuiltInType::VOID, {ast::BuiltInType::INT}};
-    function_symbol_table.push_back(print_entry);
-    function_symbol_table.push_back(printi_entry);
+    FunctionSymbolEntry print_entry = {print_name, offset_stack.top()++, ast::BuiltInType::VOID, {ast::BuiltInType::STRING}};
+    FunctionSymbolEntry printi_entry = {printi_name, offset_stack.top()++, ast::BuiltInType::VOID, {ast::BuiltInType::INT}};
+    symbol_table.insertFunction(print_entry);
+    symbol_table.insertFunction(printi_entry);
 
-    // Adding first all the symbols of the functions to the function_symbol_table attribute. 
+    // Adding first all the symbols of the functions to the functions of the symbol_table attribute. 
     bool has_valid_main = false;
 
     for (const auto& function : node.funcs) {
         std::vector<ast::BuiltInType> arguments;
         arguments.reserve(function->formals->formals.size());
         std::transform(function->formals->formals.begin(), function->formals->formals.end(), std::back_inserter(arguments),
-            [](const std::shared_ptr<ast::Formal>& formal) {
+            [](const ast::Formal *formal) {
                 return formal->type->type; 
             });
         
-        FunctionSymbolEntry function_entry = {function->id->value, offset_stack.top()++, function->return_type->type, arguments};
-        for (const auto& function_symbol : function_symbol_table) {
-            if (function_entry.name == function_symbol.name) {
-                output::errorDef(function->formals->line, function_entry.name);
-            }
+        FunctionSymbolEntry function_entry = {function->id->name, offset_stack.top()++, function->return_type->type, arguments};
+        if (symbol_table.lookupFunction(function_entry.name)) {
+            output::errorDef(function->formals->line, function->id->text());
         }
-        scope_printer.emitFunc(function_entry.name, function_entry.return_type, function_entry.arguments);
-        function_symbol_table.push_back(function_entry);
+        scope_printer.emitFunc(function->id->text(), function_entry.return_type, function_entry.arguments);
+        symbol_table.insertFunction(function_entry);
 
-        if (function_entry.name == "main" && function_entry.return_type == ast::BuiltInType::VOID && function_entry.arguments.size() == 0) {
+        if (function_entry.name == main_name && function_entry.return_type == ast::BuiltInType::VOID && function_entry.arguments.size() == 0) {
             has_valid_main = true;
         }
     }
@@ -45,33 +77,26 @@ void SemanticAnalayzerVisitor::visit(ast::Funcs &node) {
     if (!has_valid_main) {
         output::errorMainMissing();
     }
-
-    for (auto it = node.funcs.begin(); it != node.funcs.end(); ++it) {
-        // correction of 2 because of 'print' and 'printi' functionns 
-        current_function = function_symbol_table[std::distance(node.funcs.begin(), it) + 2];
-        (*it)->accept(*this);
-    }
 }
 
 void SemanticAnalayzerVisitor::visit(ast::FuncDecl &node) {
+    TimeScope function(time_report, "function", node.id->text());
+
     // Creating a new scope in the symbol_table attribute and adding symbols for the arguments of the function. 
     // Also, creating a new scope offset corresponding to the new scope. 
     scope_printer.beginScope();
     offset_stack.push(-1);
-    std::vector<SymbolEntry> symbols_in_scope; 
+    symbol_table.beginScope();
     for (const auto& formal : node.formals->formals) {
-        for (const auto& symbol : symbols_in_scope) {
-            if (symbol.name == formal->id->value) output::errorDef(formal->line, formal->id->value);
-        }
-        for (const auto& function : function_symbol_table) {
-            if (function.name == formal->id->value) output::errorDef(formal->line, formal->id->value);
+        if (symbol_table.lookup(formal->id->name) || symbol_table.lookupFunction(formal->id->name)) {
+            output::errorDef(formal->line, formal->id->text());
         }
-        SymbolEntry entry = {formal->id->value, formal->type->type, offset_stack.top()--};
-        scope_printer.emitVar(entry.name, entry.type, entry.offset);
-        symbols_in_scope.push_back(entry);
+        SymbolEntry entry = {formal->id->name, formal->type->type, offset_stack.top()--};
+        scope_printer.emitVar(formal->id->text(), entry.type, entry.offset);
+        formal->id->variable = &symbol_table.insert(entry);
+        formal->id->bound = true;
     }
-        
-    symbol_table.push_back(symbols_in_scope);
+
     offset_stack.top() = 0;
 
     node.id->accept(*this);
@@ -82,35 +107,35 @@ void SemanticAnalayzerVisitor::visit(ast::FuncDecl &node) {
     // Remove the function scope
     scope_printer.endScope();
     offset_stack.pop();
-    symbol_table.pop_back();
+    symbol_table.endScope();
 }
 
 void SemanticAnalayzerVisitor::visit(ast::If &node) {
     // Creating a new scope in the symbol_table attribute to the 'If' statment.
     scope_printer.beginScope();
     //offset_stack.push(0);
-    symbol_table.push_back(std::vector<SymbolEntry>());
+    symbol_table.beginScope();
 
     // Check if condition is boolean expression
     ast::BuiltInType condType = getExpressionType(node.condition);
 
     if (condType != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.condition->line);
+        reportMismatch(node.condition->line, {node.condition});
     }
 
     node.condition->accept(*this);
 
     // Create a new scope if the 'then' code starts a scope
-    if (typeid(*node.then) == typeid(ast::Statements)) {
+    if (ast::isa<ast::Statements>(node.then)) {
         scope_printer.beginScope();
         //offset_stack.push(0);
-        symbol_table.push_back(std::vector<SymbolEntry>());
+        symbol_table.beginScope();
 
         node.then->accept(*this);
 
         scope_printer.endScope();
         //offset_stack.pop();
-        symbol_table.pop_back();
+        symbol_table.endScope();
     } else {
         node.then->accept(*this);
     }
@@ -119,25 +144,25 @@ void SemanticAnalayzerVisitor::visit(ast::If &node) {
     // Remove the 'If' statment scope
     scope_printer.endScope();
     //offset_stack.pop();
-    symbol_table.pop_back();
+    symbol_table.endScope();
 
     if (node.otherwise) {
         // Creating a new scope in the symbol_table attribute to the 'Else' statment.
         scope_printer.beginScope();
         //offset_stack.push(0);
-        symbol_table.push_back(std::vector<SymbolEntry>());
+        symbol_table.beginScope();
 
         // Create a new scope if the 'otherwise' code starts a scope
-        if (typeid(*node.otherwise) == typeid(ast::Statements)) {
+        if (ast::isa<ast::Statements>(node.otherwise)) {
             scope_printer.beginScope();
             //offset_stack.push(0);
-            symbol_table.push_back(std::vector<SymbolEntry>());
+            symbol_table.beginScope();
 
             node.otherwise->accept(*this);
 
             scope_printer.endScope();
             //offset_stack.pop();
-            symbol_table.pop_back();
+            symbol_table.endScope();
         } else {
             node.otherwise->accept(*this);
         }
@@ -145,7 +170,7 @@ void SemanticAnalayzerVisitor::visit(ast::If &node) {
         // Remove the 'Else' statment scope
         scope_printer.endScope();
         //offset_stack.pop();
-        symbol_table.pop_back();
+        symbol_table.endScope();
     }
 }
 
@@ -153,27 +178,27 @@ void SemanticAnalayzerVisitor::visit(ast::While &node) {
     // Creating a new scope in the symbol_table attribute to the 'While' statment.
     scope_printer.beginScope();
     offset_stack.push(0);
-    symbol_table.push_back(std::vector<SymbolEntry>());
+    symbol_table.beginScope();
 
     // Check if condition is boolean expression
     ast::BuiltInType condType = getExpressionType(node.condition);
     if (condType != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.condition->line);
+        reportMismatch(node.condition->line, {node.condition});
     }
     node.condition->accept(*this);
     number_of_while_inside++;
 
     // Create a new scope if the 'body' code starts a scope
-    if (typeid(*node.body) == typeid(ast::Statements)) {
+    if (ast::isa<ast::Statements>(node.body)) {
         scope_printer.beginScope();
         offset_stack.push(0);
-        symbol_table.push_back(std::vector<SymbolEntry>());
+        symbol_table.beginScope();
 
         node.body->accept(*this);
 
         scope_printer.endScope();
         offset_stack.pop();
-        symbol_table.pop_back();   
+        symbol_table.endScope();   
     } else {
         node.body->accept(*this);
     }
@@ -182,16 +207,16 @@ void SemanticAnalayzerVisitor::visit(ast::While &node) {
     // Remove the 'While' statment scope
     scope_printer.endScope();
     offset_stack.pop();
-    symbol_table.pop_back();
+    symbol_table.endScope();
 }
 
 void SemanticAnalayzerVisitor::visit(ast::Statements &node) {
     for (const auto& statement : node.statements) {
-        if (std::dynamic_pointer_cast<ast::Statements>(statement)) {
+        if (ast::isa<ast::Statements>(statement)) {
             scope_printer.beginScope();
-            symbol_table.push_back(std::vector<SymbolEntry>());
+            symbol_table.beginScope();
             statement->accept(*this);
-            symbol_table.pop_back();
+            symbol_table.endScope();
             scope_printer.endScope();
         } else {
             statement->accept(*this);
@@ -201,113 +226,87 @@ void SemanticAnalayzerVisitor::visit(ast::Statements &node) {
 
 void SemanticAnalayzerVisitor::visit(ast::VarDecl &node) {
     // Check if variable name is occupied
-    for (const auto& scope : symbol_table) {
-        for (const auto& symbol : scope) {
-            if (symbol.name == node.id->value) {
-                output::errorDef(node.line, node.id->value);
-            }
-        }
-    } 
-    
-    for (const auto& function : function_symbol_table) {
-        if (function.name == node.id->value) {
-            output::errorDef(node.line, node.id->value);
-        }
+    if (symbol_table.lookup(node.id->name) || symbol_table.lookupFunction(node.id->name)) {
+        output::errorDef(node.line, node.id->text());
     }
 
     // Check if init_exp appropriate
     if (node.init_exp) {
         node.init_exp->accept(*this);
-        if (typeid(*node.init_exp) == typeid(ast::ID)) {            
-            for (const auto& function : function_symbol_table) {
-                if (function.name == dynamic_cast<ast::ID*>(node.init_exp.get())->value) {
-                    output::errorDefAsFunc(node.line, function.name);
+        const ast::ID *init_id = ast::dyn_cast<ast::ID>(node.init_exp);
+        if (init_id && init_id->function) {
+            output::errorDefAsFunc(node.line, init_id->text());
+        } else {
+            ast::BuiltInType initType = getExpressionType(node.init_exp);
+            if (node.type->type == ast::BuiltInType::INT) {
+                if (initType != ast::BuiltInType::INT && initType != ast::BuiltInType::BYTE) {
+                    reportMismatch(node.line, {node.init_exp});
                 }
+            } else if (node.type->type != initType) {
+                reportMismatch(node.line, {node.init_exp});
             }
         }
     }
-    
-    if (node.init_exp) {
-        ast::BuiltInType initType = getExpressionType(node.init_exp);
-        if (node.type->type == ast::BuiltInType::INT) {
-            if (initType != ast::BuiltInType::INT && initType != ast::BuiltInType::BYTE) {
-                output::errorMismatch(node.line);
-            }
-        } else if (node.type->type != initType) {
-            output::errorMismatch(node.line);
-        }
-        node.init_exp->accept(*this);
-    }
 
-    SymbolEntry entry = {node.id->value, node.type->type, offset_stack.top()++};
-    symbol_table.back().push_back(entry);
-    scope_printer.emitVar(entry.name, entry.type, entry.offset);
+    SymbolEntry entry = {node.id->name, node.type->type, offset_stack.top()++};
+    node.id->variable = &symbol_table.insert(entry);
+    node.id->bound = true;
+    scope_printer.emitVar(node.id->text(), entry.type, entry.offset);
 }
 
 void SemanticAnalayzerVisitor::visit(ast::Assign &node) {
     // Check if variable exists
-    bool is_variable_exists = false;
     ast::BuiltInType varType = ast::BuiltInType::VOID;
-    for (const auto& scope : symbol_table) {
-        for (const auto& symbol : scope) {
-            if (symbol.name == node.id->value) {
-                is_variable_exists = true;
-                varType = symbol.type;
-            }
-        }
-    } 
-
-    if (!is_variable_exists) {
-        for (const auto& function : function_symbol_table) {
-            if (node.id->value == function.name) {
-                output::errorDefAsFunc(node.line, node.id->value);
-            }
+    bind(*node.id);
+    if (node.id->variable) {
+        varType = node.id->variable->type;
+    } else {
+        if (node.id->function) {
+            output::errorDefAsFunc(node.line, node.id->text());
+        } else {
+            output::errorUndef(node.line, node.id->text());
         }
-        output::errorUndef(node.line, node.id->value);
+        // Nothing to check the value against, only look for errors inside it
+        node.exp->accept(*this);
+        return;
     }
     
     ast::BuiltInType expType = getExpressionType(node.exp);
     if (varType == ast::BuiltInType::INT) {
         if (expType != ast::BuiltInType::INT && expType != ast::BuiltInType::BYTE) {
-            output::errorMismatch(node.line);
+            reportMismatch(node.line, {node.exp});
         }
     } else if (varType != expType) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.exp});
     }
     node.exp->accept(*this);
 }
 
 void SemanticAnalayzerVisitor::visit(ast::Call &node) {
     // Check if the function exists
-    bool is_function_exists = false;
-    FunctionSymbolEntry called_function;
-
-    for (const auto& function : function_symbol_table) {
-        if (node.func_id->value == function.name) {
-            is_function_exists = true;
-            called_function = function;
-        }
-    }
-
-    if (!is_function_exists) {
+    bind(*node.func_id);
+    const FunctionSymbolEntry *called_function = node.func_id->function;
 
-        for (const auto& scope : symbol_table) {
-            for (const auto& variable : scope) {
-                if (node.func_id->value == variable.name) {
-                    output::errorDefAsVar(node.line, node.func_id->value);
-                }
-            }
+    if (!called_function) {
+        if (node.func_id->variable) {
+            output::errorDefAsVar(node.line, node.func_id->text());
+        } else {
+            output::errorUndefFunc(node.line, node.func_id->text());
         }
-
-        output::errorUndefFunc(node.line, node.func_id->value);
+        // No prototype to check the arguments against, only look for errors inside them
+        node.args->accept(*this);
+        return;
     }
 
     // Check if the passed args are apropriate
     bool is_args_match = true;
-    if (node.args->exps.size() == called_function.arguments.size()) {
-        for (size_t index = 0; index < called_function.arguments.size(); ++index) {
-            auto argument = called_function.arguments[index];
-            std::shared_ptr<ast::Exp> arg_exp = node.args->exps[index];
+    if (node.args->exps.size() == called_function->arguments.size()) {
+        for (size_t index = 0; index < called_function->arguments.size(); ++index) {
+            auto argument = called_function->arguments[index];
+            ast::Exp *arg_exp = node.args->exps[index];
+            if (output::diagnostics().allErrors() && isUnresolved(arg_exp)) {
+                continue;
+            }
             ast::BuiltInType argType = getExpressionType(arg_exp);
 
             switch (argument) {
@@ -341,11 +340,11 @@ void SemanticAnalayzerVisitor::visit(ast::Call &node) {
 
     if (!is_args_match) {
         std::vector<std::string> string_args; 
-        std::transform(called_function.arguments.begin(), called_function.arguments.end(), std::back_inserter(string_args),
+        std::transform(called_function->arguments.begin(), called_function->arguments.end(), std::back_inserter(string_args),
         [](const ast::BuiltInType argument) {
             return output::toString(argument);
         });
-        output::errorPrototypeMismatch(node.line, node.func_id->value, string_args);
+        output::errorPrototypeMismatch(node.line, node.func_id->text(), string_args);
     }
 
     node.args->accept(*this);
@@ -366,10 +365,11 @@ void SemanticAnalayzerVisitor::visit(ast::Continue &node) {
 }
 
 void SemanticAnalayzerVisitor::visit(ast::Return &node) {
-    ast::BuiltInType type_to_return = current_function.return_type;
+    ast::BuiltInType type_to_return = current_function->return_type;
 
     if (!node.exp && type_to_return != ast::BuiltInType::VOID) {
         output::errorMismatch(node.line);
+        return;
     }
 
     if (node.exp) {
@@ -381,27 +381,27 @@ void SemanticAnalayzerVisitor::visit(ast::Return &node) {
     switch (type_to_return) {
         case ast::BuiltInType::VOID:
             if (node.exp) {
-                output::errorMismatch(node.line);
+                reportMismatch(node.line, {node.exp});
             }
             break;
         case ast::BuiltInType::BOOL:
             if (expType != ast::BuiltInType::BOOL) {
-                output::errorMismatch(node.line);
+                reportMismatch(node.line, {node.exp});
             }
             break;
         case ast::BuiltInType::BYTE:
             if (expType != ast::BuiltInType::BYTE) {
-                output::errorMismatch(node.line);
+                reportMismatch(node.line, {node.exp});
             }
             break;
         case ast::BuiltInType::INT:
             if (expType != ast::BuiltInType::INT && expType != ast::BuiltInType::BYTE) {
-                output::errorMismatch(node.line);
+                reportMismatch(node.line, {node.exp});
             }
             break;
         case ast::BuiltInType::STRING:
             if (expType != ast::BuiltInType::STRING) {
-                output::errorMismatch(node.line);
+                reportMismatch(node.line, {node.exp});
             }
             break;
     }
@@ -420,19 +420,11 @@ void SemanticAnalayzerVisitor::visit(ast::String &node) {}
 void SemanticAnalayzerVisitor::visit(ast::Bool &node) {}
 
 void SemanticAnalayzerVisitor::visit(ast::ID &node) {
-    for (auto it = symbol_table.rbegin(); it != symbol_table.rend(); ++it) {
-        for (const auto& entry : *it) {
-            if (entry.name == node.value) {
-                return;
-            }
-        }
-    }
-    for (const auto& func : function_symbol_table) {
-        if (func.name == node.value) {
-            return;
-        }
+    bind(node);
+    if (node.variable || node.function) {
+        return;
     }
-    output::errorUndef(node.line, node.value);
+    output::errorUndef(node.line, node.text());
 }
 
 void SemanticAnalayzerVisitor::visit(ast::BinOp &node) {
@@ -442,7 +434,7 @@ void SemanticAnalayzerVisitor::visit(ast::BinOp &node) {
     ast::BuiltInType t2 = getExpressionType(node.right);
     if ((t1 != ast::BuiltInType::INT && t1 != ast::BuiltInType::BYTE) ||
         (t2 != ast::BuiltInType::INT && t2 != ast::BuiltInType::BYTE)) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.left, node.right});
     }
 }
 
@@ -453,14 +445,14 @@ void SemanticAnalayzerVisitor::visit(ast::RelOp &node) {
     ast::BuiltInType t2 = getExpressionType(node.right);
     if ((t1 != ast::BuiltInType::INT && t1 != ast::BuiltInType::BYTE) ||
         (t2 != ast::BuiltInType::INT && t2 != ast::BuiltInType::BYTE)) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.left, node.right});
     }
 }
 
 void SemanticAnalayzerVisitor::visit(ast::Not &node) {
     node.exp->accept(*this);
     if (getExpressionType(node.exp) != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.exp});
     }
 }
 
@@ -469,7 +461,7 @@ void SemanticAnalayzerVisitor::visit(ast::And &node) {
     node.right->accept(*this);
     if (getExpressionType(node.left) != ast::BuiltInType::BOOL ||
         getExpressionType(node.right) != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.left, node.right});
     }
 }
 
@@ -478,7 +470,7 @@ void SemanticAnalayzerVisitor::visit(ast::Or &node) {
     node.right->accept(*this);
     if (getExpressionType(node.left) != ast::BuiltInType::BOOL ||
         getExpressionType(node.right) != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.left, node.right});
     }
 }
 
@@ -493,7 +485,7 @@ void SemanticAnalayzerVisitor::visit(ast::Cast &node) {
           (t1 == ast::BuiltInType::BYTE && t2 == ast::BuiltInType::INT) ||
           (t1 == ast::BuiltInType::INT && t2 == ast::BuiltInType::INT) ||
           (t1 == ast::BuiltInType::BYTE && t2 == ast::BuiltInType::BYTE))) {
-        output::errorMismatch(node.line);
+        reportMismatch(node.line, {node.exp});
     }
 }
 
@@ -506,47 +498,168 @@ void SemanticAnalayzerVisitor::visit(ast::Formal &node) {}
 
 void SemanticAnalayzerVisitor::visit(ast::Formals &node) {}
 
-ast::BuiltInType SemanticAnalayzerVisitor::getExpressionType(std::shared_ptr<ast::Exp> exp) {
-    if (std::dynamic_pointer_cast<ast::Num>(exp)) return ast::BuiltInType::INT;
-    if (std::dynamic_pointer_cast<ast::NumB>(exp)) return ast::BuiltInType::BYTE;
-    if (std::dynamic_pointer_cast<ast::String>(exp)) return ast::BuiltInType::STRING;
-    if (std::dynamic_pointer_cast<ast::Bool>(exp)) return ast::BuiltInType::BOOL;
-    if (std::dynamic_pointer_cast<ast::Not>(exp)) return ast::BuiltInType::BOOL;
-    if (std::dynamic_pointer_cast<ast::RelOp>(exp)) return ast::BuiltInType::BOOL;
-    if (std::dynamic_pointer_cast<ast::And>(exp)) return ast::BuiltInType::BOOL;
-    if (std::dynamic_pointer_cast<ast::Or>(exp)) return ast::BuiltInType::BOOL;
-
-    if (auto binOp = std::dynamic_pointer_cast<ast::BinOp>(exp)) {
-        ast::BuiltInType left = getExpressionType(binOp->left);
-        ast::BuiltInType right = getExpressionType(binOp->right);
-        if (left == ast::BuiltInType::BYTE && right == ast::BuiltInType::BYTE)
-            return ast::BuiltInType::BYTE;
-        return ast::BuiltInType::INT;
+ast::BuiltInType SemanticAnalayzerVisitor::getExpressionType(ast::Exp *exp) {
+    if (!exp->typed) {
+        exp->type = inferExpressionType(exp);
+        exp->typed = true;
     }
+    return exp->type;
+}
 
-    if (auto id = std::dynamic_pointer_cast<ast::ID>(exp)) {
-        for (auto it = symbol_table.rbegin(); it != symbol_table.rend(); ++it) {
-            for (const auto& entry : *it) {
-                if (entry.name == id->value) {
-                    return entry.type;
-                }
+ast::BuiltInType SemanticAnalayzerVisitor::inferExpressionType(ast::Exp *exp) {
+    switch (exp->kind) {
+        case ast::NodeKind::Num:
+            return ast::BuiltInType::INT;
+        case ast::NodeKind::NumB:
+            return ast::BuiltInType::BYTE;
+        case ast::NodeKind::String:
+            return ast::BuiltInType::STRING;
+        case ast::NodeKind::Bool:
+        case ast::NodeKind::Not:
+        case ast::NodeKind::RelOp:
+        case ast::NodeKind::And:
+        case ast::NodeKind::Or:
+            return ast::BuiltInType::BOOL;
+
+        case ast::NodeKind::BinOp: {
+            auto binOp = ast::cast<ast::BinOp>(exp);
+            ast::BuiltInType left = getExpressionType(binOp->left);
+            ast::BuiltInType right = getExpressionType(binOp->right);
+            if (left == ast::BuiltInType::BYTE && right == ast::BuiltInType::BYTE)
+                return ast::BuiltInType::BYTE;
+            return ast::BuiltInType::INT;
+        }
+
+        case ast::NodeKind::ID: {
+            auto id = ast::cast<ast::ID>(exp);
+            bind(*id);
+            if (id->variable) {
+                return id->variable->type;
+            }
+            return ast::BuiltInType::VOID;
+        }
+
+        case ast::NodeKind::Call: {
+            auto call = ast::cast<ast::Call>(exp);
+            bind(*call->func_id);
+            if (call->func_id->function) {
+                return call->func_id->function->return_type;
             }
+            return ast::BuiltInType::VOID;
         }
-        return ast::BuiltInType::VOID;
+
+        case ast::NodeKind::Cast:
+            return ast::cast<ast::Cast>(exp)->target_type->type;
+
+        default:
+            return ast::BuiltInType::VOID;
+    }
+}
+
+void SemanticAnalayzerVisitor::bind(ast::ID &id) {
+    if (id.bound) {
+        return;
+    }
+    id.variable = symbol_table.lookup(id.name);
+    if (!id.variable) {
+        id.function = symbol_table.lookupFunction(id.name);
     }
+    id.bound = true;
+}
+bool SemanticAnalayzerVisitor::isUnresolved(ast::Exp *exp) {
+    if (ast::ID *id = ast::dyn_cast<ast::ID>(exp)) {
+        bind(*id);
+        return !id->variable && !id->function;
+    }
+    if (ast::Call *call = ast::dyn_cast<ast::Call>(exp)) {
+        bind(*call->func_id);
+        return !call->func_id->function;
+    }
+    return false;
+}
 
-    if (auto call = std::dynamic_pointer_cast<ast::Call>(exp)) {
-        for (const auto& func : function_symbol_table) {
-            if (func.name == call->func_id->value) {
-                return func.return_type;
+void SemanticAnalayzerVisitor::reportMismatch(int line, std::initializer_list<ast::Exp *> operands) {
+    if (output::diagnostics().allErrors()) {
+        for (ast::Exp *operand : operands) {
+            if (operand && isUnresolved(operand)) {
+                return;
             }
         }
-        return ast::BuiltInType::VOID;
     }
+    output::errorMismatch(line);
+}
+
+void SemanticAnalayzerVisitor::reportMemory(MemoryReport &report) const {
+    MemoryUsage variables = symbol_table.variableMemory();
+    for (const SymbolTable &table : body_tables) {
+        variables += table.variableMemory();
+    }
+    report.add("symbol_table", variables);
+    report.add("function_symbol_table", symbol_table.functionMemory());
+    report.add("ScopePrinter", scope_printer.memoryUsage());
+}
+
+FunctionResult SemanticAnalayzerVisitor::analyzeBody(ast::FuncDecl &function, size_t index, bool all_errors) {
+    // correction of 2 because of 'print' and 'printi' functionns
+    SemanticAnalayzerVisitor body_visitor(*this, &symbol_table.function(index + 2));
+    output::Diagnostics diagnostics(all_errors);
+    output::Diagnostics *previous = output::setDiagnostics(&diagnostics);
+    try {
+        function.accept(body_visitor);
+    } catch (const output::CompilationError &) {
+        // Kept in `diagnostics`
+    }
+    output::setDiagnostics(previous);
+
+    body_tables[index] = std::move(body_visitor.symbol_table);
+    return {body_visitor.scope_printer.body(), diagnostics.errors()};
+}
 
-    if (auto cast_node = std::dynamic_pointer_cast<ast::Cast>(exp)) {
-        return cast_node->target_type->type;
+void SemanticAnalayzerVisitor::analyzeBodiesSeparately(ast::Funcs &node) {
+    std::vector<FunctionResult> results(node.funcs.size());
+    body_tables.resize(node.funcs.size());
+    bool all_errors = output::diagnostics().allErrors();
+    FunctionCache::Key context = {};
+    if (cache) {
+        context = FunctionCache::context(symbol_table, node.funcs.size() + 2, all_errors, print_scopes);
     }
 
-    return ast::BuiltInType::VOID;
+    auto analyze = [&](size_t i) {
+        ast::FuncDecl &function = *node.funcs[i];
+        if (!cache) {
+            results[i] = analyzeBody(function, i, all_errors);
+            return;
+        }
+
+        FunctionCache::Key key = cache->key(function, context);
+        if (cache->load(key, function.id->line, results[i])) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        results[i] = analyzeBody(function, i, all_errors);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        cache->store(key, function.id->line, results[i],
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    };
+    // A single job runs on the calling thread, which may well be a worker of the compile server already
+    if (jobs > 1) {
+        ThreadPool pool(jobs);
+        for (size_t i = 0; i < node.funcs.size(); ++i) {
+            pool.submit([&analyze, i] { analyze(i); });
+        }
+        pool.wait();
+    } else {
+        for (size_t i = 0; i < node.funcs.size(); ++i) {
+            analyze(i);
+        }
+    }
+
+    // Report the errors again in source order: with first-error reporting this stops at the same error as the
+    // sequential analysis
+    for (FunctionResult &result : results) {
+        for (output::Diagnostic &error : result.errors) {
+            output::diagnostics().report(std::move(error));
+        }
+        scope_printer.appendBody(result.scopes);
+    }
 }
@@ -1,3 +1,4 @@
+#include <initializer_list>
 #include <string>
 #include <stack>
 #include <vector>
@@ -5,28 +6,20 @@
 #include "visitor.hpp"
 #include "nodes.hpp"
 #include "output.hpp"
-
-struct SymbolEntry {
-    std::string name;
-    ast::BuiltInType type;
-    int offset;
-};
-
-struct FunctionSymbolEntry {
-    std::string name;
-    int offset;
-    // Return type of the function
-    ast::BuiltInType return_type;
-    // List of formal parameters
-    std::vector<ast::BuiltInType> arguments;
-};
+#include "symbol_table.hpp"
+#include "function_cache.hpp"
+#include "time_report.hpp"
 
 
 class SemanticAnalayzerVisitor : public Visitor {
 public:
 
-    /*C'tor of the visitor*/
-    SemanticAnalayzerVisitor();
+    /*C'tor of the visitor. Without print_scopes the scopes are only checked, and no output is built.
+      With jobs > 1 the function bodies are checked concurrently on that many threads, with the same output.
+      With a cache, the bodies that did not change since they were stored are not checked again.
+      With a time report, the signature collection, the bodies and every function are timed*/
+    explicit SemanticAnalayzerVisitor(bool print_scopes = true, size_t jobs = 1, FunctionCache *cache = nullptr,
+                                      TimeReport *time_report = nullptr);
 
     /* override the visit functions */
 
@@ -84,6 +77,9 @@ public:
 
     output::ScopePrinter scope_printer;
 
+    // Adds the symbol tables and the scope printer to the report
+    void reportMemory(MemoryReport &report) const;
+
 private:
     /*
      Eeach scope requires new offset counter. therefore we maintaining stack of offets.
@@ -92,13 +88,58 @@ private:
     std::stack<int> offset_stack;
 
     /*
-     Each std::vector<SymbolEntry> in the wrapper vector, represnts a scope, 
-     and the elements inside this vector are the symbols in the scope. 
+     Scoped variables and the global functions. Each beginScope()/endScope() pair of the table
+     represents a scope, and the symbols declared in between belong to it.
     */
-    std::vector<std::vector<SymbolEntry>> symbol_table;
-    std::vector<SymbolEntry> symbols_in_current_scope; // used in formal parameters checking
-    std::vector<FunctionSymbolEntry> function_symbol_table;
-    FunctionSymbolEntry current_function;
+    SymbolTable symbol_table;
+    // Entry of the function whose body is being analyzed
+    const FunctionSymbolEntry *current_function;
     int number_of_while_inside; 
-    ast::BuiltInType getExpressionType(std::shared_ptr<ast::Exp> exp);
+    // Interned names of the library functions and of the entry point
+    Symbol print_name;
+    Symbol printi_name;
+    Symbol main_name;
+    /*
+     Returns the type of the expression. The type of every expression node is inferred once, bottom-up from the
+     types of its operands, and cached on the node; later calls only read the cached value.
+    */
+    ast::BuiltInType getExpressionType(ast::Exp *exp);
+    ast::BuiltInType inferExpressionType(ast::Exp *exp);
+
+    /*
+     Name binding: resolves the identifier against the current scopes the first time it is used and stores the
+     declaration it refers to on the node. Every later check reads ID::variable / ID::function instead of looking
+     the name up again.
+    */
+    void bind(ast::ID &id);
+
+    // Declares the library functions and every function of the program in the global table
+    void collectSignatures(ast::Funcs &node);
+
+    /*
+     Error recovery: a name that is not defined has no type, so every check above it fails as well. When all the
+     errors are collected, only the undefined name itself is reported and not the mismatches it causes. With the
+     default first-error reporting the checks behave exactly as before.
+    */
+    bool isUnresolved(ast::Exp *exp);
+    void reportMismatch(int line, std::initializer_list<ast::Exp *> operands);
+
+    /*
+     Parallel analysis: once every signature is in the global table, each function body only reads that table and
+     owns its own scopes, offsets and loop depth. Every body is then checked by a visitor of its own, with its own
+     local table, ScopePrinter and diagnostics, and the results are merged in source order.
+     The same separation lets the cache serve the result of a body instead of checking it. A body served from
+     the cache is not visited, so its nodes keep no types or bindings.
+    */
+    // Visitor of one function body, sharing the functions of `parent`
+    SemanticAnalayzerVisitor(const SemanticAnalayzerVisitor &parent, const FunctionSymbolEntry *function);
+    void analyzeBodiesSeparately(ast::Funcs &node);
+    FunctionResult analyzeBody(ast::FuncDecl &function, size_t index, bool all_errors);
+
+    bool print_scopes;
+    size_t jobs;
+    FunctionCache *cache;
+    TimeReport *time_report;
+    // Local tables of the bodies checked in parallel, kept because the AST points into them
+    std::vector<SymbolTable> body_tables;
 };
\ No newline at end of file
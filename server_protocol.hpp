@@ -0,0 +1,87 @@
+#ifndef SERVER_PROTOCOL_HPP
+#define SERVER_PROTOCOL_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Protocol of the compile server (see compile_server.hpp)
+ * A client sends a RequestHeader followed by `size` bytes of program text, and gets back a ResponseHeader
+ * followed by `size` bytes of output: exactly what hw3 prints for that program. A connection may carry any
+ * number of requests, one after the other. Integers are in the byte order of the machine, which both ends share.
+ */
+namespace protocol {
+
+    const uint32_t REQUEST_MAGIC = 0x71337768;
+    const uint32_t RESPONSE_MAGIC = 0x72337768;
+
+    // Socket used when none is given
+    const char DEFAULT_SOCKET[] = "/tmp/hw3.sock";
+
+    // Largest program a request may carry. The server answers a larger one with REJECTED and closes the connection
+    const uint64_t MAX_REQUEST_SIZE = 8 << 20;
+
+    enum RequestFlags : uint32_t {
+        ALL_ERRORS = 1 << 0,
+        CHECK_ONLY = 1 << 1,
+    };
+
+    enum ResponseStatus : uint32_t {
+        COMPILED = 0,
+        HAS_ERRORS = 1,
+        // The request was not compiled. The output says why
+        REJECTED = 2,
+    };
+
+    struct RequestHeader {
+        uint32_t magic;
+        // RequestFlags
+        uint32_t flags;
+        uint64_t size;
+    };
+
+    struct ResponseHeader {
+        uint32_t magic;
+        // ResponseStatus
+        uint32_t status;
+        uint64_t size;
+    };
+
+    // Reads exactly `size` bytes. Returns false on end of stream or error
+    inline bool readFully(int fd, void *data, size_t size) {
+        char *cursor = static_cast<char *>(data);
+        while (size > 0) {
+            ssize_t read = ::read(fd, cursor, size);
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read <= 0) {
+                return false;
+            }
+            cursor += read;
+            size -= read;
+        }
+        return true;
+    }
+
+    // Writes exactly `size` bytes. A closed peer is an error, not a SIGPIPE
+    inline bool writeFully(int fd, const void *data, size_t size) {
+        const char *cursor = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t written = send(fd, cursor, size, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            cursor += written;
+            size -= written;
+        }
+        return true;
+    }
+}
+
+#endif //SERVER_PROTOCOL_HPP
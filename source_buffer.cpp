@@ -0,0 +1,102 @@
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source_buffer.hpp"
+
+// Number of NUL bytes the scanner needs after the text
+static const size_t PADDING = 2;
+
+SourceBuffer::SourceBuffer() : text(nullptr), length(0), mapped(0), owned(PADDING, '\0') {
+    text = &owned[0];
+}
+
+SourceBuffer::~SourceBuffer() {
+    release();
+}
+
+void SourceBuffer::release() {
+    if (mapped) {
+        munmap(text, mapped);
+        mapped = 0;
+    }
+    owned.assign(PADDING, '\0');
+    text = &owned[0];
+    length = 0;
+}
+
+bool SourceBuffer::map(const std::string &path) {
+    release();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return false;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        // Pipes and devices cannot be mapped
+        close(fd);
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        read(in);
+        return true;
+    }
+
+    size_t size = info.st_size;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t total = (size + PADDING + page - 1) / page * page;
+
+    // Reserve zeroed memory for the text and the NUL bytes after it, then map the file over its start. The bytes
+    // of the last file page past the end of the file read as zeros too
+    void *memory = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (size > 0 && mmap(memory, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(memory, total);
+        close(fd);
+        return false;
+    }
+    close(fd);
+    madvise(memory, total, MADV_SEQUENTIAL);
+
+    owned.clear();
+    text = static_cast<char *>(memory);
+    length = size;
+    mapped = total;
+    return true;
+}
+
+void SourceBuffer::read(std::istream &in) {
+    release();
+    owned.assign(std::istreambuf_iterator<char>(in), {});
+    length = owned.size();
+    owned.append(PADDING, '\0');
+    text = &owned[0];
+}
+
+char *SourceBuffer::allocate(size_t size) {
+    release();
+    owned.assign(size + PADDING, '\0');
+    length = size;
+    text = &owned[0];
+    return text;
+}
+
+char *SourceBuffer::data() {
+    return text;
+}
+
+size_t SourceBuffer::size() const {
+    return length;
+}
@@ -0,0 +1,49 @@
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+/* SourceBuffer class
+ * The text of one program, laid out so the scanner can scan it in place: writable and followed by two NUL bytes.
+ * A file is mapped into memory privately (copy-on-write, so nothing is ever written back); other input is read
+ * into an owned string. Literals in the AST are views into this buffer, so it must outlive the AST.
+ */
+class SourceBuffer {
+public:
+    SourceBuffer();
+
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer &) = delete;
+
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    // Maps the file at the given path, or reads it if it is not a regular file. Returns false if it cannot be read
+    bool map(const std::string &path);
+
+    // Reads the whole stream
+    void read(std::istream &in);
+
+    // Makes room for a text of the given size, which the caller writes at the returned address. The memory of the
+    // previous text is reused when it is large enough
+    char *allocate(size_t size);
+
+    // The text, followed by two NUL bytes
+    char *data();
+
+    // Size of the text, without the NUL bytes
+    size_t size() const;
+
+private:
+    void release();
+
+    char *text;
+    size_t length;
+    // Size of the mapping, or 0 if the text is held in `owned`
+    size_t mapped;
+    std::string owned;
+};
+
+#endif //SOURCE_BUFFER_HPP
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <utility>
+
+#include "ssa_builder.hpp"
+
+namespace ir {
+
+    /* Helper functions */
+
+    // Keeps the blocks reachable from the entry, in reverse postorder, and numbers them by their new position
+    static void orderBlocks(Function &function) {
+        std::vector<bool> reached(function.blocks.size(), false);
+        std::vector<Block *> postorder;
+        std::vector<std::pair<Block *, size_t>> stack = {{function.blocks[0], 0}};
+        reached[0] = true;
+        while (!stack.empty()) {
+            Block *block = stack.back().first;
+            size_t next = stack.back().second++;
+            if (next == block->succs.size()) {
+                postorder.push_back(block);
+                stack.pop_back();
+                continue;
+            }
+            Block *succ = block->succs[next];
+            if (!reached[succ->id]) {
+                reached[succ->id] = true;
+                stack.emplace_back(succ, 0);
+            }
+        }
+
+        for (Block *block : postorder) {
+            block->preds.erase(std::remove_if(block->preds.begin(), block->preds.end(), [&](Block *pred) {
+                return !reached[pred->id];
+            }), block->preds.end());
+        }
+        function.blocks.assign(postorder.rbegin(), postorder.rend());
+        for (size_t i = 0; i < function.blocks.size(); ++i) {
+            function.blocks[i]->id = static_cast<int32_t>(i);
+        }
+    }
+
+    // Places the PHIs of every variable, pruned by liveness, at the start of their blocks
+    static void placePhis(Function &function, const std::vector<std::vector<Block *>> &frontiers) {
+        size_t block_count = function.blocks.size();
+        int32_t variable_count = static_cast<int32_t>(function.variables.size());
+
+        // Blocks that store each variable, and blocks that load it before any store (where it is live on entry)
+        std::vector<std::vector<Block *>> defs(variable_count);
+        std::vector<std::vector<Block *>> uses(variable_count);
+        std::vector<int32_t> defined_in(variable_count, -1);
+        std::vector<int32_t> used_in(variable_count, -1);
+        for (Block *block : function.blocks) {
+            for (Instruction *instruction : block->instructions) {
+                int32_t variable = instruction->immediate;
+                if (instruction->opcode == Opcode::STORE && defined_in[variable] != block->id) {
+                    defined_in[variable] = block->id;
+                    defs[variable].push_back(block);
+                } else if (instruction->opcode == Opcode::LOAD && defined_in[variable] != block->id &&
+                           used_in[variable] != block->id) {
+                    used_in[variable] = block->id;
+                    uses[variable].push_back(block);
+                }
+            }
+        }
+
+        // Marks by variable, so that nothing is cleared between two variables
+        std::vector<int32_t> defines(block_count, -1);
+        std::vector<int32_t> live(block_count, -1);
+        std::vector<int32_t> has_phi(block_count, -1);
+        std::vector<int32_t> queued(block_count, -1);
+        std::vector<std::vector<Instruction *>> phis(block_count);
+        std::vector<Block *> work;
+        for (int32_t variable = 0; variable < variable_count; ++variable) {
+            for (Block *block : defs[variable]) {
+                defines[block->id] = variable;
+            }
+
+            // Live on entry: from the upward exposed loads backwards, up to the stores
+            for (Block *block : uses[variable]) {
+                live[block->id] = variable;
+                work.push_back(block);
+            }
+            while (!work.empty()) {
+                Block *block = work.back();
+                work.pop_back();
+                for (Block *pred : block->preds) {
+                    if (live[pred->id] != variable && defines[pred->id] != variable) {
+                        live[pred->id] = variable;
+                        work.push_back(pred);
+                    }
+                }
+            }
+
+            // The iterated dominance frontier of the stores, where the variable is live
+            for (Block *block : defs[variable]) {
+                queued[block->id] = variable;
+                work.push_back(block);
+            }
+            while (!work.empty()) {
+                Block *block = work.back();
+                work.pop_back();
+                for (Block *frontier : frontiers[block->id]) {
+                    if (has_phi[frontier->id] == variable) {
+                        continue;
+                    }
+                    has_phi[frontier->id] = variable;
+                    if (live[frontier->id] == variable) {
+                        Instruction *phi = function.create(Opcode::PHI, function.variables[variable].type,
+                                                           std::vector<Instruction *>(frontier->preds.size()),
+                                                           variable);
+                        phi->block = frontier;
+                        phis[frontier->id].push_back(phi);
+                    }
+                    if (queued[frontier->id] != variable) {
+                        queued[frontier->id] = variable;
+                        work.push_back(frontier);
+                    }
+                }
+            }
+        }
+
+        for (Block *block : function.blocks) {
+            block->instructions.insert(block->instructions.begin(), phis[block->id].begin(), phis[block->id].end());
+        }
+    }
+
+    // Replaces the loads and the stores with the values stored, walking the dominator tree
+    static void rename(Function &function, const DominatorTree &dominators) {
+        std::vector<std::vector<Instruction *>> stacks(function.variables.size());
+        std::vector<Instruction *> replacement(function.valueCount(), nullptr);
+        // The variables pushed so far, popped as the walk leaves their block
+        std::vector<int32_t> pushed;
+        // Constants read by the loads that come before any store, by type
+        std::vector<Instruction *> zeros(ast::BuiltInType::STRING + 1, nullptr);
+        auto current = [&](int32_t variable) {
+            if (!stacks[variable].empty()) {
+                return stacks[variable].back();
+            }
+            ast::BuiltInType type = function.variables[variable].type;
+            if (!zeros[type]) {
+                zeros[type] = function.create(Opcode::CONST, type);
+                zeros[type]->block = function.blocks[0];
+            }
+            return zeros[type];
+        };
+
+        // Position of every edge among the predecessors of its target, for the operands of the PHIs
+        std::vector<std::vector<int32_t>> pred_index(function.blocks.size());
+        for (Block *block : function.blocks) {
+            pred_index[block->id].assign(block->succs.size(), -1);
+        }
+        for (Block *block : function.blocks) {
+            for (size_t i = 0; i < block->preds.size(); ++i) {
+                Block *pred = block->preds[i];
+                for (size_t j = 0; j < pred->succs.size(); ++j) {
+                    if (pred->succs[j] == block && pred_index[pred->id][j] == -1) {
+                        pred_index[pred->id][j] = static_cast<int32_t>(i);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Each block is visited twice: on the way down (with the size of `pushed` to return to), and on the way up
+        std::vector<std::pair<Block *, size_t>> walk = {{function.blocks[0], SIZE_MAX}};
+        while (!walk.empty()) {
+            Block *block = walk.back().first;
+            size_t mark = walk.back().second;
+            walk.pop_back();
+            if (mark != SIZE_MAX) {
+                for (; pushed.size() > mark; pushed.pop_back()) {
+                    stacks[pushed.back()].pop_back();
+                }
+                continue;
+            }
+            walk.emplace_back(block, pushed.size());
+
+            for (Instruction *instruction : block->instructions) {
+                if (instruction->opcode == Opcode::PHI) {
+                    stacks[instruction->immediate].push_back(instruction);
+                    pushed.push_back(instruction->immediate);
+                    continue;
+                }
+                for (Instruction *&operand : instruction->operands) {
+                    if (replacement[operand->id]) {
+                        operand = replacement[operand->id];
+                    }
+                }
+                if (instruction->opcode == Opcode::LOAD) {
+                    replacement[instruction->id] = current(instruction->immediate);
+                } else if (instruction->opcode == Opcode::STORE) {
+                    stacks[instruction->immediate].push_back(instruction->operands[0]);
+                    pushed.push_back(instruction->immediate);
+                }
+            }
+            for (size_t i = 0; i < block->succs.size(); ++i) {
+                Block *succ = block->succs[i];
+                for (Instruction *phi : succ->instructions) {
+                    if (phi->opcode != Opcode::PHI) {
+                        break;
+                    }
+                    phi->operands[pred_index[block->id][i]] = current(phi->immediate);
+                }
+            }
+
+            const std::vector<Block *> &children = dominators.children(block);
+            for (auto child = children.rbegin(); child != children.rend(); ++child) {
+                walk.emplace_back(*child, SIZE_MAX);
+            }
+        }
+
+        for (Block *block : function.blocks) {
+            block->instructions.erase(std::remove_if(block->instructions.begin(), block->instructions.end(),
+                                                     [](Instruction *instruction) {
+                                                         return instruction->opcode == Opcode::LOAD ||
+                                                                instruction->opcode == Opcode::STORE;
+                                                     }), block->instructions.end());
+        }
+        std::vector<Instruction *> &entry = function.blocks[0]->instructions;
+        for (Instruction *zero : zeros) {
+            if (zero) {
+                entry.insert(entry.begin(), zero);
+            }
+        }
+    }
+
+    void buildSsa(Function &function) {
+        orderBlocks(function);
+        DominatorTree dominators(function);
+        placePhis(function, dominators.frontiers(function));
+        rename(function, dominators);
+        function.renumber();
+    }
+}
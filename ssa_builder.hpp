@@ -0,0 +1,19 @@
+#ifndef SSA_BUILDER_HPP
+#define SSA_BUILDER_HPP
+
+#include "ir.hpp"
+
+namespace ir {
+
+    /* Turns a function built by the IrBuilder to pruned SSA form, by the algorithm of Cytron et al.:
+     * 1. The unreachable blocks are dropped, and the others ordered in reverse postorder.
+     * 2. A variable gets a PHI in the iterated dominance frontier of the blocks that store it, but only where it is
+     *    live on entry, so that no PHI is dead from the start.
+     * 3. A walk of the dominator tree replaces every LOAD with the value last stored on the way, and fills the PHIs.
+     * Every step is linear in the size of the function and of the frontiers, besides the O(E log V) of the dominator
+     * tree. A variable read before any store reads 0.
+     */
+    void buildSsa(Function &function);
+}
+
+#endif //SSA_BUILDER_HPP
@@ -0,0 +1,99 @@
+#include <cassert>
+
+#include "symbol_table.hpp"
+
+/* Helper functions */
+
+// Returns the slot of the given handle in a handle-indexed vector, growing the vector if needed
+static int &slotOf(std::vector<int> &index, Symbol name) {
+    if (name >= index.size()) {
+        index.resize(name + 1, -1);
+    }
+    return index[name];
+}
+
+/* SymbolTable class */
+
+SymbolTable::SymbolTable(const SymbolTable *globals) : globals(globals) {}
+
+void SymbolTable::beginScope() {
+    scope_marks.push_back(bindings.size());
+}
+
+void SymbolTable::endScope() {
+    size_t mark = scope_marks.back();
+    scope_marks.pop_back();
+
+    // Undo the bindings of the scope in reverse order, restoring the shadowed ones
+    while (bindings.size() > mark) {
+        const Binding &binding = bindings.back();
+        index[binding.entry->name] = binding.shadowed;
+        bindings.pop_back();
+    }
+}
+
+const SymbolEntry &SymbolTable::insert(const SymbolEntry &entry) {
+    entries.push_back(entry);
+    int &slot = slotOf(index, entry.name);
+    bindings.push_back({&entries.back(), slot});
+    slot = static_cast<int>(bindings.size() - 1);
+    return entries.back();
+}
+
+const SymbolEntry *SymbolTable::lookup(Symbol name) const {
+    if (name >= index.size() || index[name] < 0) {
+        return nullptr;
+    }
+    return bindings[index[name]].entry;
+}
+
+const FunctionSymbolEntry &SymbolTable::insertFunction(const FunctionSymbolEntry &entry) {
+    assert(!globals && "functions are declared in the global table");
+    slotOf(function_index, entry.name) = static_cast<int>(functions.size());
+    functions.push_back(entry);
+    return functions.back();
+}
+
+const FunctionSymbolEntry *SymbolTable::lookupFunction(Symbol name) const {
+    if (globals) {
+        return globals->lookupFunction(name);
+    }
+    if (name >= function_index.size() || function_index[name] < 0) {
+        return nullptr;
+    }
+    return &functions[function_index[name]];
+}
+
+const FunctionSymbolEntry &SymbolTable::function(size_t index) const {
+    if (globals) {
+        return globals->function(index);
+    }
+    return functions[index];
+}
+
+MemoryUsage SymbolTable::variableMemory() const {
+    // A deque has no capacity; its entries are counted as both live and reserved
+    MemoryUsage usage;
+    usage.objects = entries.size();
+    usage.live_bytes = usage.peak_bytes = entries.size() * sizeof(SymbolEntry);
+    MemoryUsage containers = containerUsage(bindings);
+    containers += containerUsage(scope_marks);
+    containers += containerUsage(index);
+    usage.live_bytes += containers.live_bytes;
+    usage.peak_bytes += containers.peak_bytes;
+    return usage;
+}
+
+MemoryUsage SymbolTable::functionMemory() const {
+    MemoryUsage usage;
+    usage.objects = functions.size();
+    for (const FunctionSymbolEntry &function : functions) {
+        MemoryUsage arguments = containerUsage(function.arguments);
+        usage.live_bytes += sizeof(FunctionSymbolEntry) + arguments.live_bytes;
+        usage.peak_bytes += sizeof(FunctionSymbolEntry) + arguments.peak_bytes;
+    }
+    MemoryUsage index = containerUsage(function_index);
+    usage.live_bytes += index.live_bytes;
+    usage.peak_bytes += index.peak_bytes;
+    return usage;
+}
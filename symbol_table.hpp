@@ -0,0 +1,92 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <deque>
+#include <vector>
+#include "interner.hpp"
+#include "nodes.hpp"
+#include "mem_report.hpp"
+
+struct SymbolEntry {
+    Symbol name;
+    ast::BuiltInType type;
+    int offset;
+};
+
+struct FunctionSymbolEntry {
+    Symbol name;
+    int offset;
+    // Return type of the function
+    ast::BuiltInType return_type;
+    // List of formal parameters
+    std::vector<ast::BuiltInType> arguments;
+};
+
+/* SymbolTable class
+ * Scoped table of variables and the global table of functions.
+ * Every visible variable is reachable through a name -> binding index, and the bindings themselves are kept on a
+ * stack that doubles as the undo log of the scopes: popping a scope pops its bindings and restores whatever they
+ * shadowed. Names are interned handles, so the index is a plain vector indexed by handle and lookup, insertion and
+ * popping a scope are all O(1) amortized.
+ * Entries outlive their scope: the AST keeps pointers to them after the analysis, so they are only freed together
+ * with the table.
+ * A table can also hold only the local scopes of one function body and take its functions from a shared global
+ * table, so several bodies can be analyzed at the same time against the same read-only functions.
+ */
+class SymbolTable {
+public:
+    // A table of its own functions, or of local scopes only if `globals` is given. Functions are then looked up in
+    // `globals`, which must not change while this table is in use
+    explicit SymbolTable(const SymbolTable *globals = nullptr);
+
+    // Opens a new (innermost) scope
+    void beginScope();
+
+    // Closes the innermost scope, hiding every variable declared in it
+    void endScope();
+
+    // Declares a variable in the innermost scope and returns the stored entry
+    const SymbolEntry &insert(const SymbolEntry &entry);
+
+    // Returns the innermost visible variable with the given name, or nullptr if there is none
+    const SymbolEntry *lookup(Symbol name) const;
+
+    // Declares a function in the global scope and returns the stored entry. Not allowed on a table of local scopes
+    const FunctionSymbolEntry &insertFunction(const FunctionSymbolEntry &entry);
+
+    // Returns the function with the given name, or nullptr if there is none
+    const FunctionSymbolEntry *lookupFunction(Symbol name) const;
+
+    // Returns the function declared index-th (library functions included)
+    const FunctionSymbolEntry &function(size_t index) const;
+
+    // Memory of the variables (entries, bindings, scopes and index) and of the functions this table holds itself
+    MemoryUsage variableMemory() const;
+    MemoryUsage functionMemory() const;
+
+private:
+    struct Binding {
+        const SymbolEntry *entry;
+        // Position of the binding this one shadows in `bindings`, or -1 if the name was not visible before
+        int shadowed;
+    };
+
+    // Every variable ever declared. A deque never moves its elements, so returned entries stay valid
+    std::deque<SymbolEntry> entries;
+    // Stack of the visible variables, innermost last
+    std::vector<Binding> bindings;
+    // Size of `bindings` when each open scope was created
+    std::vector<size_t> scope_marks;
+    // Name -> position in `bindings` of the innermost visible variable with that name, or -1
+    std::vector<int> index;
+
+    // Table the functions are looked up in, when this one only holds local scopes
+    const SymbolTable *globals;
+
+    // Functions in declaration order. A deque never moves its elements, so returned entries stay valid
+    std::deque<FunctionSymbolEntry> functions;
+    // Name -> position in `functions`, or -1
+    std::vector<int> function_index;
+};
+
+#endif //SYMBOL_TABLE_HPP
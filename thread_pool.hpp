@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* ThreadPool class
+ * A fixed set of worker threads with work stealing. Every worker has its own task queue: it takes its own work from
+ * the back of the queue, and once that runs dry it steals from the front of the others. Tasks are spread over the
+ * queues round-robin when submitted. Tasks must not throw.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads);
+
+    // Waits for the submitted tasks and stops the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished
+    void wait();
+
+    size_t size() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Body of the worker thread that owns queues[self]
+    void run(size_t self);
+
+    // Takes a task from the worker's own queue, or steals one from another queue
+    bool pop(size_t self, std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    // Queue the next submitted task goes to
+    std::atomic<size_t> next;
+    // Tasks sitting in the queues, used by idle workers to know when to wake up
+    std::atomic<size_t> queued;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    // Tasks submitted and not finished yet. Guarded by `mutex`
+    size_t pending;
+    bool stopping;
+};
+
+#endif //THREAD_POOL_HPP
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "time_report.hpp"
+
+/* Helper functions */
+
+// Number of functions listed by the summary
+static const size_t SLOWEST_FUNCTIONS = 5;
+
+// Phase of the per-function intervals
+static const char FUNCTION_PHASE[] = "function";
+
+// Writes the string as a JSON string literal
+static void writeJsonString(std::ostream &os, const std::string &str) {
+    os << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            os << escaped;
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+/* TimeReport class */
+
+const std::string TimeScope::NO_DETAIL;
+
+TimeReport::TimeReport() : origin_ns(now()) {}
+
+uint64_t TimeReport::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t TimeReport::threadId() {
+    return threads.emplace(std::this_thread::get_id(), threads.size()).first->second;
+}
+
+void TimeReport::record(const char *phase, const std::string &detail, uint64_t start_ns, uint64_t duration_ns) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back({phase, detail, start_ns, duration_ns, threadId(), true});
+}
+
+void TimeReport::add(const char *phase, uint64_t duration_ns) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back({phase, std::string(), now() - duration_ns, duration_ns, threadId(), false});
+}
+
+void TimeReport::printSummary(std::ostream &os) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    double wall_ns = static_cast<double>(now() - origin_ns);
+
+    // Phases in the order they first appear
+    struct Phase {
+        std::string name;
+        size_t count;
+        uint64_t total_ns;
+    };
+    std::vector<Phase> phases;
+    std::vector<const Event *> functions;
+    for (const Event &event : events) {
+        auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase &phase) {
+            return phase.name == event.phase;
+        });
+        if (it == phases.end()) {
+            phases.push_back({event.phase, 0, 0});
+            it = phases.end() - 1;
+        }
+        ++it->count;
+        it->total_ns += event.duration_ns;
+        if (!strcmp(event.phase, FUNCTION_PHASE)) {
+            functions.push_back(&event);
+        }
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-20s %10s %14s %10s\n", "phase", "count", "total (ms)", "% of wall");
+    os << line;
+    for (const Phase &phase : phases) {
+        snprintf(line, sizeof(line), "%-20s %10zu %14.3f %10.1f\n", phase.name.c_str(), phase.count,
+                 phase.total_ns / 1e6, 100.0 * phase.total_ns / wall_ns);
+        os << line;
+    }
+    snprintf(line, sizeof(line), "%-20s %10s %14.3f\n", "wall", "", wall_ns / 1e6);
+    os << line;
+
+    if (functions.empty()) {
+        return;
+    }
+    size_t shown = std::min(SLOWEST_FUNCTIONS, functions.size());
+    std::partial_sort(functions.begin(), functions.begin() + shown, functions.end(),
+                      [](const Event *a, const Event *b) { return a->duration_ns > b->duration_ns; });
+    os << "slowest functions:\n";
+    for (size_t i = 0; i < shown; ++i) {
+        snprintf(line, sizeof(line), "  %-30s %14.3f ms\n", functions[i]->detail.c_str(),
+                 functions[i]->duration_ns / 1e6);
+        os << line;
+    }
+}
+
+bool TimeReport::writeTrace(const std::string &path) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream out(path, std::ios::binary);
+
+    // Complete ("X") events, with times in microseconds from the creation of the report
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    char times[96];
+    for (const Event &event : events) {
+        if (!event.interval) {
+            continue;
+        }
+        out << (first ? "" : ",\n") << "{\"name\":";
+        writeJsonString(out, event.detail.empty() ? event.phase : event.detail);
+        out << ",\"cat\":";
+        writeJsonString(out, event.phase);
+        snprintf(times, sizeof(times), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu}",
+                 (event.start_ns - origin_ns) / 1e3, event.duration_ns / 1e3, event.thread);
+        out << times;
+        first = false;
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+}
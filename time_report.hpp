@@ -0,0 +1,88 @@
+#ifndef TIME_REPORT_HPP
+#define TIME_REPORT_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* TimeReport class
+ * Timings of the phases of the compilation, and of the analysis of every function, recorded by TimeScope objects.
+ * They are printed as a summary table, or written as a Chrome trace (trace-event JSON, loadable in chrome://tracing
+ * or Perfetto). Phases may be recorded from several threads.
+ * Without a report nothing is timed: every TimeScope then costs a single null check.
+ */
+class TimeReport {
+public:
+    TimeReport();
+
+    // Records an interval of the given phase. `phase` must be a literal, `detail` tells apart the intervals of one
+    // phase (the name of a function)
+    void record(const char *phase, const std::string &detail, uint64_t start_ns, uint64_t duration_ns);
+
+    // Adds time spent in many short pieces, like the scanner called token by token from the parser. It appears in
+    // the summary only
+    void add(const char *phase, uint64_t duration_ns);
+
+    // Per phase: number of intervals, total time and share of the time since the report was created. Then the
+    // slowest functions
+    void printSummary(std::ostream &os) const;
+
+    // Writes the intervals as a Chrome trace. Returns false if the file cannot be written
+    bool writeTrace(const std::string &path) const;
+
+    // Current time, in ns
+    static uint64_t now();
+
+private:
+    struct Event {
+        const char *phase;
+        std::string detail;
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        // Small id of the recording thread
+        size_t thread;
+        // False for the time given to add()
+        bool interval;
+    };
+
+    size_t threadId();
+
+    uint64_t origin_ns;
+    mutable std::mutex mutex;
+    std::vector<Event> events;
+    std::unordered_map<std::thread::id, size_t> threads;
+};
+
+/* TimeScope class
+ * Records the time between its construction and its destruction in the report, if there is one. The detail is
+ * held by reference, so it must outlive the scope.
+ */
+class TimeScope {
+public:
+    TimeScope(TimeReport *report, const char *phase, const std::string &detail = NO_DETAIL)
+            : report(report), phase(phase), detail(detail), start_ns(report ? TimeReport::now() : 0) {}
+
+    ~TimeScope() {
+        if (report) {
+            report->record(phase, detail, start_ns, TimeReport::now() - start_ns);
+        }
+    }
+
+    TimeScope(const TimeScope &) = delete;
+
+    TimeScope &operator=(const TimeScope &) = delete;
+
+private:
+    static const std::string NO_DETAIL;
+
+    TimeReport *report;
+    const char *phase;
+    const std::string &detail;
+    uint64_t start_ns;
+};
+
+#endif //TIME_REPORT_HPP
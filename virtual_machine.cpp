@@ -0,0 +1,308 @@
+#include <algorithm>
+
+#include "virtual_machine.hpp"
+
+// Threaded dispatch needs the labels-as-values extension
+#if defined(__GNUC__)
+#define VM_THREADED 1
+#else
+#define VM_THREADED 0
+#endif
+
+/* Helper functions */
+
+// 32-bit arithmetic, wrapping instead of overflowing
+static inline int32_t wrapAdd(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+static inline int32_t wrapSub(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+}
+
+static inline int32_t wrapMul(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+}
+
+namespace vm {
+
+    VirtualMachine::VirtualMachine(const Program &program, size_t stack_size)
+            : program(program), stack(new int32_t[stack_size]), stack_size(stack_size) {}
+
+    bool VirtualMachine::run(std::ostream &out) {
+#if VM_THREADED
+        static const void *const handlers[] = {
+#define VM_OPCODE_HANDLER(name, operands) &&op_##name,
+                VM_OPCODES(VM_OPCODE_HANDLER)
+#undef VM_OPCODE_HANDLER
+        };
+#define VM_CASE(name) op_##name:
+#define VM_NEXT() goto *(pc++)->handler
+#else
+#define VM_CASE(name) case name:
+#define VM_NEXT() continue
+#endif
+
+        // Thread the code: every opcode becomes its handler, the operands stay as they are
+        code.resize(program.code.size());
+        for (size_t i = 0; i < program.code.size();) {
+            Opcode opcode = static_cast<Opcode>(program.code[i]);
+#if VM_THREADED
+            code[i].handler = handlers[opcode];
+#else
+            code[i].value = opcode;
+#endif
+            for (int operand = 1; operand <= operandCount(opcode); ++operand) {
+                code[i + operand].value = program.code[i + operand];
+            }
+            i += 1 + operandCount(opcode);
+        }
+
+        const Word *const start = code.data();
+        const Function *const functions = program.functions.data();
+        int32_t *const stack_end = stack.get() + stack_size;
+        // Deep enough for any program that does not recurse forever
+        const size_t max_frames = stack_size / 4;
+        frames.clear();
+
+        // The next word of the code, the frame of the running function and the top of the stack
+        const Word *pc = start;
+        int32_t *base = stack.get();
+        int32_t *sp = stack.get();
+
+#if VM_THREADED
+        VM_NEXT();
+#else
+        for (;;) {
+            switch ((pc++)->value) {
+#endif
+        VM_CASE(PUSH)
+        {
+            *sp++ = (pc++)->value;
+            VM_NEXT();
+        }
+        VM_CASE(LOAD)
+        {
+            *sp++ = base[(pc++)->value];
+            VM_NEXT();
+        }
+        VM_CASE(STORE)
+        {
+            base[(pc++)->value] = *--sp;
+            VM_NEXT();
+        }
+        VM_CASE(POP)
+        {
+            --sp;
+            VM_NEXT();
+        }
+        VM_CASE(ADD)
+        {
+            --sp;
+            sp[-1] = wrapAdd(sp[-1], sp[0]);
+            VM_NEXT();
+        }
+        VM_CASE(SUB)
+        {
+            --sp;
+            sp[-1] = wrapSub(sp[-1], sp[0]);
+            VM_NEXT();
+        }
+        VM_CASE(MUL)
+        {
+            --sp;
+            sp[-1] = wrapMul(sp[-1], sp[0]);
+            VM_NEXT();
+        }
+        VM_CASE(DIV)
+        {
+            --sp;
+            if (sp[0] == 0) {
+                goto division_by_zero;
+            }
+            // INT_MIN / -1 overflows, and wraps back to INT_MIN
+            sp[-1] = sp[0] == -1 ? wrapSub(0, sp[-1]) : sp[-1] / sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(TRUNC)
+        {
+            sp[-1] &= 0xFF;
+            VM_NEXT();
+        }
+        VM_CASE(EQ)
+        {
+            --sp;
+            sp[-1] = sp[-1] == sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(NE)
+        {
+            --sp;
+            sp[-1] = sp[-1] != sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(LT)
+        {
+            --sp;
+            sp[-1] = sp[-1] < sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(GT)
+        {
+            --sp;
+            sp[-1] = sp[-1] > sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(LE)
+        {
+            --sp;
+            sp[-1] = sp[-1] <= sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(GE)
+        {
+            --sp;
+            sp[-1] = sp[-1] >= sp[0];
+            VM_NEXT();
+        }
+        VM_CASE(NOT)
+        {
+            sp[-1] = !sp[-1];
+            VM_NEXT();
+        }
+        VM_CASE(JUMP)
+        {
+            pc = start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_IF_FALSE)
+        {
+            pc = *--sp ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_IF_TRUE)
+        {
+            pc = *--sp ? start + pc->value : pc + 1;
+            VM_NEXT();
+        }
+        VM_CASE(CALL)
+        {
+            const Function &callee = functions[pc->value];
+            int32_t *frame = sp - callee.params;
+            if (frame + callee.frame_size + callee.max_stack > stack_end || frames.size() == max_frames) {
+                goto stack_overflow;
+            }
+            // Locals start at 0
+            std::fill(sp, frame + callee.frame_size, 0);
+            frames.push_back({pc + 1, base});
+            base = frame;
+            sp = frame + callee.frame_size;
+            pc = start + callee.entry;
+            VM_NEXT();
+        }
+        VM_CASE(RET)
+        {
+            sp = base;
+            base = frames.back().base;
+            pc = frames.back().return_pc;
+            frames.pop_back();
+            VM_NEXT();
+        }
+        VM_CASE(RET_VALUE)
+        {
+            int32_t value = sp[-1];
+            sp = base;
+            *sp++ = value;
+            base = frames.back().base;
+            pc = frames.back().return_pc;
+            frames.pop_back();
+            VM_NEXT();
+        }
+        VM_CASE(PRINT)
+        {
+            out << program.strings[(pc++)->value] << '\n';
+            VM_NEXT();
+        }
+        VM_CASE(PRINTI)
+        {
+            out << *--sp << '\n';
+            VM_NEXT();
+        }
+        VM_CASE(HALT)
+        {
+            return true;
+        }
+        VM_CASE(LOAD2)
+        {
+            sp[0] = base[pc[0].value];
+            sp[1] = base[pc[1].value];
+            sp += 2;
+            pc += 2;
+            VM_NEXT();
+        }
+        VM_CASE(ADD_CONST)
+        {
+            sp[-1] = wrapAdd(sp[-1], (pc++)->value);
+            VM_NEXT();
+        }
+        VM_CASE(INC_LOCAL)
+        {
+            int32_t &local = base[pc[0].value];
+            local = wrapAdd(local, pc[1].value);
+            pc += 2;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_EQ)
+        {
+            sp -= 2;
+            pc = sp[0] == sp[1] ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_NE)
+        {
+            sp -= 2;
+            pc = sp[0] != sp[1] ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_LT)
+        {
+            sp -= 2;
+            pc = sp[0] < sp[1] ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_GT)
+        {
+            sp -= 2;
+            pc = sp[0] > sp[1] ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_LE)
+        {
+            sp -= 2;
+            pc = sp[0] <= sp[1] ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_UNLESS_GE)
+        {
+            sp -= 2;
+            pc = sp[0] >= sp[1] ? pc + 1 : start + pc->value;
+            VM_NEXT();
+        }
+#if !VM_THREADED
+            default:
+                return false;
+            }
+        }
+#endif
+#undef VM_CASE
+#undef VM_NEXT
+
+    division_by_zero:
+        out << "Error division by zero" << '\n';
+        return false;
+
+    stack_overflow:
+        out << "Error stack overflow" << '\n';
+        return false;
+    }
+}
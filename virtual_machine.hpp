@@ -0,0 +1,55 @@
+#ifndef VIRTUAL_MACHINE_HPP
+#define VIRTUAL_MACHINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "bytecode.hpp"
+
+namespace vm {
+
+    /* VirtualMachine class
+     * Runs a compiled program (see BytecodeCompiler). The code is translated once into threaded code, where every
+     * opcode is the address of its handler, so each handler jumps straight to the next one (GCC's computed goto;
+     * other compilers get a switch loop).
+     * Like the programs compiled by the course's backend, print and printi end the line, int arithmetic wraps at
+     * 32 bits, byte arithmetic wraps at 8 bits, and a division by zero prints "Error division by zero" and stops the
+     * program. Running out of stack prints "Error stack overflow" and stops it too.
+     */
+    class VirtualMachine {
+    public:
+        // Values of the stack: locals and operands of every active call
+        static const size_t DEFAULT_STACK_SIZE = 1 << 20;
+
+        explicit VirtualMachine(const Program &program, size_t stack_size = DEFAULT_STACK_SIZE);
+
+        // Runs the program from main, writing what it prints to `out`. Returns false if it stopped on a runtime
+        // error, which is printed to `out` as well
+        bool run(std::ostream &out);
+
+    private:
+        // Code word: the handler of an opcode, or an operand
+        union Word {
+            const void *handler;
+            int32_t value;
+        };
+
+        // Return address and frame of a caller
+        struct Frame {
+            const Word *return_pc;
+            int32_t *base;
+        };
+
+        const Program &program;
+        // Not initialized: a call clears the locals of its frame
+        std::unique_ptr<int32_t[]> stack;
+        size_t stack_size;
+        std::vector<Word> code;
+        std::vector<Frame> frames;
+    };
+}
+
+#endif //VIRTUAL_MACHINE_HPP